@@ -0,0 +1,326 @@
+package rtcm
+
+import (
+	"math"
+	"math/rand"
+	"reflect"
+	"strconv"
+	"testing"
+	"time"
+)
+
+// ephFld field of ephemeris message {kind, bits, name, scale}, kind: U=unsigned,
+// F=unsigned scaled, S=signed scaled, G=sign-magnitude scaled, X=reserved,
+// name: EphT/GephT field (array element with index suffix) or a lower-case
+// field checked by the message test
+type ephFld struct {
+	kind  byte
+	bits  uint
+	name  string
+	scale float64
+}
+
+const sc2rad = 3.1415926535898 // semi-circle to radian (IS-GPS)
+
+// p2 2^-n
+func p2(n int) float64 {
+	return math.Ldexp(1, -n)
+}
+
+// ephemeris message layouts by RTCM 10403.3 (after message number)
+var ephMsgs = map[int][]ephFld{
+	1019: {
+		{'U', 6, "prn", 1}, {'U', 10, "week", 1}, {'U', 4, "Sva", 1}, {'U', 2, "Code", 1},
+		{'S', 14, "Idot", p2(43) * sc2rad}, {'U', 8, "Iode", 1}, {'F', 16, "toc", 16},
+		{'S', 8, "F2", p2(55)}, {'S', 16, "F1", p2(43)}, {'S', 22, "F0", p2(31)},
+		{'U', 10, "Iodc", 1}, {'S', 16, "Crs", p2(5)}, {'S', 16, "Deln", p2(43) * sc2rad},
+		{'S', 32, "M0", p2(31) * sc2rad}, {'S', 16, "Cuc", p2(29)}, {'F', 32, "E", p2(33)},
+		{'S', 16, "Cus", p2(29)}, {'F', 32, "sqrtA", p2(19)}, {'F', 16, "Toes", 16},
+		{'S', 16, "Cic", p2(29)}, {'S', 32, "OMG0", p2(31) * sc2rad}, {'S', 16, "Cis", p2(29)},
+		{'S', 32, "Io", p2(31) * sc2rad}, {'S', 16, "Crc", p2(5)}, {'S', 32, "Omg", p2(31) * sc2rad},
+		{'S', 24, "OMGd", p2(43) * sc2rad}, {'S', 8, "Tgd0", p2(31)}, {'U', 6, "Svh", 1},
+		{'U', 1, "Flag", 1}, {'U', 1, "fit", 1},
+	},
+	1020: {
+		{'U', 6, "prn", 1}, {'U', 5, "frq", 1}, {'X', 4, "", 1}, {'U', 5, "tk_h", 1},
+		{'U', 6, "tk_m", 1}, {'F', 1, "tk_s", 30}, {'U', 1, "bn", 1}, {'X', 1, "", 1},
+		{'U', 7, "tb", 1},
+		{'G', 24, "Vel0", p2(20) * 1e3}, {'G', 27, "Pos0", p2(11) * 1e3}, {'G', 5, "Acc0", p2(30) * 1e3},
+		{'G', 24, "Vel1", p2(20) * 1e3}, {'G', 27, "Pos1", p2(11) * 1e3}, {'G', 5, "Acc1", p2(30) * 1e3},
+		{'G', 24, "Vel2", p2(20) * 1e3}, {'G', 27, "Pos2", p2(11) * 1e3}, {'G', 5, "Acc2", p2(30) * 1e3},
+		{'X', 1, "", 1}, {'G', 11, "Gamn", p2(40)}, {'X', 3, "", 1}, {'G', 22, "Taun", p2(30)},
+		{'G', 5, "Dtaun", p2(30)}, {'U', 5, "Age", 1},
+	},
+	1041: {
+		{'U', 6, "prn", 1}, {'U', 10, "week", 1}, {'S', 22, "F0", p2(31)}, {'S', 16, "F1", p2(43)},
+		{'S', 8, "F2", p2(55)}, {'U', 4, "Sva", 1}, {'F', 16, "toc", 16}, {'S', 8, "Tgd0", p2(31)},
+		{'S', 22, "Deln", p2(41) * sc2rad}, {'U', 8, "Iode", 1}, {'X', 10, "", 1}, {'U', 2, "Svh", 1},
+		{'S', 15, "Cuc", p2(28)}, {'S', 15, "Cus", p2(28)}, {'S', 15, "Cic", p2(28)},
+		{'S', 15, "Cis", p2(28)}, {'S', 15, "Crc", 0.0625}, {'S', 15, "Crs", 0.0625},
+		{'S', 14, "Idot", p2(43) * sc2rad}, {'S', 32, "M0", p2(31) * sc2rad}, {'F', 16, "Toes", 16},
+		{'F', 32, "E", p2(33)}, {'F', 32, "sqrtA", p2(19)}, {'S', 32, "OMG0", p2(31) * sc2rad},
+		{'S', 32, "Omg", p2(31) * sc2rad}, {'S', 22, "OMGd", p2(41) * sc2rad}, {'S', 32, "Io", p2(31) * sc2rad},
+	},
+	1042: {
+		{'U', 6, "prn", 1}, {'U', 13, "week", 1}, {'U', 4, "Sva", 1}, {'S', 14, "Idot", p2(43) * sc2rad},
+		{'U', 5, "Iode", 1}, {'F', 17, "toc", 8}, {'S', 11, "F2", p2(66)}, {'S', 22, "F1", p2(50)},
+		{'S', 24, "F0", p2(33)}, {'U', 5, "Iodc", 1}, {'S', 18, "Crs", p2(6)},
+		{'S', 16, "Deln", p2(43) * sc2rad}, {'S', 32, "M0", p2(31) * sc2rad}, {'S', 18, "Cuc", p2(31)},
+		{'F', 32, "E", p2(33)}, {'S', 18, "Cus", p2(31)}, {'F', 32, "sqrtA", p2(19)}, {'F', 17, "Toes", 8},
+		{'S', 18, "Cic", p2(31)}, {'S', 32, "OMG0", p2(31) * sc2rad}, {'S', 18, "Cis", p2(31)},
+		{'S', 32, "Io", p2(31) * sc2rad}, {'S', 18, "Crc", p2(6)}, {'S', 32, "Omg", p2(31) * sc2rad},
+		{'S', 24, "OMGd", p2(43) * sc2rad}, {'S', 10, "Tgd0", 1e-10}, {'S', 10, "Tgd1", 1e-10},
+		{'U', 1, "Svh", 1},
+	},
+	1044: {
+		{'U', 4, "prn", 1}, {'F', 16, "toc", 16}, {'S', 8, "F2", p2(55)}, {'S', 16, "F1", p2(43)},
+		{'S', 22, "F0", p2(31)}, {'U', 8, "Iode", 1}, {'S', 16, "Crs", p2(5)},
+		{'S', 16, "Deln", p2(43) * sc2rad}, {'S', 32, "M0", p2(31) * sc2rad}, {'S', 16, "Cuc", p2(29)},
+		{'F', 32, "E", p2(33)}, {'S', 16, "Cus", p2(29)}, {'F', 32, "sqrtA", p2(19)}, {'F', 16, "Toes", 16},
+		{'S', 16, "Cic", p2(29)}, {'S', 32, "OMG0", p2(31) * sc2rad}, {'S', 16, "Cis", p2(29)},
+		{'S', 32, "Io", p2(31) * sc2rad}, {'S', 16, "Crc", p2(5)}, {'S', 32, "Omg", p2(31) * sc2rad},
+		{'S', 24, "OMGd", p2(43) * sc2rad}, {'S', 14, "Idot", p2(43) * sc2rad}, {'U', 2, "Code", 1},
+		{'U', 10, "week", 1}, {'U', 4, "Sva", 1}, {'U', 6, "Svh", 1}, {'S', 8, "Tgd0", p2(31)},
+		{'U', 10, "Iodc", 1}, {'U', 1, "fit", 1},
+	},
+	1045: {
+		{'U', 6, "prn", 1}, {'U', 12, "week", 1}, {'U', 10, "Iode", 1}, {'U', 8, "Sva", 1},
+		{'S', 14, "Idot", p2(43) * sc2rad}, {'F', 14, "toc", 60}, {'S', 6, "F2", p2(59)},
+		{'S', 21, "F1", p2(46)}, {'S', 31, "F0", p2(34)}, {'S', 16, "Crs", p2(5)},
+		{'S', 16, "Deln", p2(43) * sc2rad}, {'S', 32, "M0", p2(31) * sc2rad}, {'S', 16, "Cuc", p2(29)},
+		{'F', 32, "E", p2(33)}, {'S', 16, "Cus", p2(29)}, {'F', 32, "sqrtA", p2(19)}, {'F', 14, "Toes", 60},
+		{'S', 16, "Cic", p2(29)}, {'S', 32, "OMG0", p2(31) * sc2rad}, {'S', 16, "Cis", p2(29)},
+		{'S', 32, "Io", p2(31) * sc2rad}, {'S', 16, "Crc", p2(5)}, {'S', 32, "Omg", p2(31) * sc2rad},
+		{'S', 24, "OMGd", p2(43) * sc2rad}, {'S', 10, "Tgd0", p2(32)}, {'U', 2, "e5a_hs", 1},
+		{'U', 1, "e5a_dvs", 1}, {'X', 7, "", 1},
+	},
+	1046: {
+		{'U', 6, "prn", 1}, {'U', 12, "week", 1}, {'U', 10, "Iode", 1}, {'U', 8, "Sva", 1},
+		{'S', 14, "Idot", p2(43) * sc2rad}, {'F', 14, "toc", 60}, {'S', 6, "F2", p2(59)},
+		{'S', 21, "F1", p2(46)}, {'S', 31, "F0", p2(34)}, {'S', 16, "Crs", p2(5)},
+		{'S', 16, "Deln", p2(43) * sc2rad}, {'S', 32, "M0", p2(31) * sc2rad}, {'S', 16, "Cuc", p2(29)},
+		{'F', 32, "E", p2(33)}, {'S', 16, "Cus", p2(29)}, {'F', 32, "sqrtA", p2(19)}, {'F', 14, "Toes", 60},
+		{'S', 16, "Cic", p2(29)}, {'S', 32, "OMG0", p2(31) * sc2rad}, {'S', 16, "Cis", p2(29)},
+		{'S', 32, "Io", p2(31) * sc2rad}, {'S', 16, "Crc", p2(5)}, {'S', 32, "Omg", p2(31) * sc2rad},
+		{'S', 24, "OMGd", p2(43) * sc2rad}, {'S', 10, "Tgd0", p2(32)}, {'S', 10, "Tgd1", p2(32)},
+		{'U', 2, "e5b_hs", 1}, {'U', 1, "e5b_dvs", 1}, {'U', 2, "e1_hs", 1}, {'U', 1, "e1_dvs", 1},
+	},
+}
+
+// ephFrame build an ephemeris frame of the message type with random fields
+// except the fixed ones {name: raw value} and return the decoded values of
+// the fields by name
+func ephFrame(r *rand.Rand, typ int, fixed map[string]uint32) ([]byte, map[string]float64) {
+	flds := ephMsgs[typ]
+	if typ == 63 {
+		flds = ephMsgs[1042]
+	}
+	f := [][2]uint32{{uint32(typ), 12}}
+	values := map[string]float64{}
+	nbit := 12
+	for _, fld := range flds {
+		raw, ok := fixed[fld.name]
+		if !ok {
+			raw = r.Uint32() & (1<<fld.bits - 1)
+		}
+		if fld.kind == 'X' {
+			raw = 0
+		}
+		f = append(f, [2]uint32{raw, uint32(fld.bits)})
+		nbit += int(fld.bits)
+
+		sign := uint32(1) << (fld.bits - 1)
+		switch fld.kind {
+		case 'U', 'F':
+			values[fld.name] = float64(raw) * fld.scale
+		case 'S':
+			values[fld.name] = float64(int32(raw<<(32-fld.bits))>>(32-fld.bits)) * fld.scale
+		case 'G':
+			values[fld.name] = float64(raw&(sign-1)) * fld.scale
+			if raw&sign != 0 {
+				values[fld.name] = -values[fld.name]
+			}
+		}
+	}
+	for ; nbit < ephLen[typ]*8; nbit++ {
+		f = append(f, [2]uint32{0, 1}) // padding to the message length
+	}
+	return makeFrame(f), values
+}
+
+// checkEphFields check the fields of EphT/GephT by the upper-case names
+func checkEphFields(t *testing.T, typ int, eph interface{}, values map[string]float64) {
+	t.Helper()
+	v := reflect.ValueOf(eph)
+	for name, want := range values {
+		if name == "" || name[0] < 'A' || name[0] > 'Z' {
+			continue
+		}
+		fv := v.FieldByName(name)
+		if !fv.IsValid() { // array element with index suffix
+			i, _ := strconv.Atoi(name[len(name)-1:])
+			fv = v.FieldByName(name[:len(name)-1]).Index(i)
+		}
+		var got float64
+		switch fv.Kind() {
+		case reflect.Int:
+			got = float64(fv.Int())
+		default:
+			got = fv.Float()
+		}
+		if math.Abs(got-want) > 1e-12*math.Abs(want) {
+			t.Errorf("type %d %s: expected %g, but got %g", typ, name, want, got)
+		}
+	}
+}
+
+// satellite numbers of the first satellites of the systems
+const (
+	satGLO = 33
+	satGAL = satGLO + 27
+	satQZS = satGAL + 36
+	satCMP = satQZS + 10
+	satIRN = satCMP + 63
+)
+
+func TestDecodeEph(t *testing.T) {
+	// decoder time (GPST) and current time for week rollovers, GPS week 2139
+	// and BDS week 783 with toe/toc at the start of 2021-01-06 12:00 UTC
+	now := time.Date(2021, 1, 6, 12, 0, 0, 0, time.UTC).Unix()
+	timeset(GtimeT{Time: now})
+	defer timereset()
+	gpst := time.Date(1980, 1, 6, 0, 0, 0, 0, time.UTC).Unix() + 2139*604800
+	bdt := time.Date(2006, 1, 1, 0, 0, 0, 0, time.UTC).Unix() + 783*604800 + 14
+	const toe = 302400
+
+	cases := []struct {
+		typ    int
+		sat    int    // satellite number of prn 1
+		week   uint32 // week field
+		toe    int64  // toe (GPST)
+		toes   uint32 // toes and toc fields
+		ephset int
+		fit    [2]float64 // fit interval of the fit flag 0 and 1
+	}{
+		{1019, 1, 2139 % 1024, gpst + toe, toe / 16, 0, [2]float64{4, 0}},
+		{1041, satIRN, 2139 % 1024, gpst + toe, toe / 16, 0, [2]float64{0, 0}},
+		{1042, satCMP, 783, bdt + toe, toe / 8, 0, [2]float64{0, 0}},
+		{63, satCMP, 783, bdt + toe, toe / 8, 0, [2]float64{0, 0}},
+		{1044, satQZS, 2139 % 1024, gpst + toe, toe / 16, 0, [2]float64{2, 0}},
+		{1045, satGAL, 2139 - 1024, gpst + toe, toe / 60, 1, [2]float64{0, 0}},
+		{1046, satGAL, 2139 - 1024, gpst + toe, toe / 60, 0, [2]float64{0, 0}},
+	}
+	for _, c := range cases {
+		dec, err := NewDecoder()
+		if err != nil {
+			t.Fatal(err)
+		}
+		defer dec.Close()
+		dec.setTime(GtimeT{Time: now + 18})
+		dec.setOpt("-EPHALL")
+
+		r := rand.New(rand.NewSource(int64(c.typ)))
+		for i := 0; i < 4; i++ {
+			prn := uint32(1 + i)
+			frame, values := ephFrame(r, c.typ, map[string]uint32{
+				"prn": prn, "week": c.week, "Toes": c.toes, "toc": c.toes, "fit": uint32(i % 2),
+			})
+			status, rtcm := dec.decodeFrame(frame)
+			if status != 2 || rtcm.EphSat != c.sat+i || rtcm.EphSet != c.ephset {
+				t.Fatalf("type %d prn %d: expected to get status %d sat %d set %d, but got %d %d %d",
+					c.typ, prn, 2, c.sat+i, c.ephset, status, rtcm.EphSat, rtcm.EphSet)
+			}
+			var eph EphT
+			for _, e := range rtcm.Nav.Eph {
+				if e.Sat == c.sat+i {
+					eph = e
+				}
+			}
+			checkEphFields(t, c.typ, eph, values)
+			week := 2139
+			if c.sat == satCMP {
+				week = 783
+			}
+			if eph.Week != week || eph.Toe.Time != c.toe || eph.Toc.Time != c.toe || eph.Ttr.Time != now+18 {
+				t.Errorf("type %d prn %d: expected to get week %d toe/toc %d ttr %d, but got %d %d %d %d",
+					c.typ, prn, week, c.toe, now+18, eph.Week, eph.Toe.Time, eph.Toc.Time, eph.Ttr.Time)
+			}
+			if eph.A != values["sqrtA"]*values["sqrtA"] || eph.Fit != c.fit[i%2] {
+				t.Errorf("type %d prn %d: expected to get A %g fit %g, but got %g %g",
+					c.typ, prn, values["sqrtA"]*values["sqrtA"], c.fit[i%2], eph.A, eph.Fit)
+			}
+			// post-fixes of the message
+			svh, code, iodc, flag := int(values["Svh"]), int(values["Code"]), int(values["Iodc"]), int(values["Flag"])
+			switch c.typ {
+			case 1041:
+				iodc = int(values["Iode"])
+			case 1044:
+				flag = 1
+			case 1045:
+				svh = int(values["e5a_hs"])<<4 + int(values["e5a_dvs"])<<3
+				code, iodc = 1<<1+1<<8, int(values["Iode"])
+			case 1046:
+				svh = int(values["e5b_hs"])<<7 + int(values["e5b_dvs"])<<6 +
+					int(values["e1_hs"])<<1 + int(values["e1_dvs"])
+				code, iodc = 1<<0+1<<2+1<<9, int(values["Iode"])
+			}
+			if eph.Svh != svh || eph.Code != code || eph.Iodc != iodc || eph.Flag != flag {
+				t.Errorf("type %d prn %d: expected to get svh %d code %d iodc %d flag %d, but got %d %d %d %d",
+					c.typ, prn, svh, code, iodc, flag, eph.Svh, eph.Code, eph.Iodc, eph.Flag)
+			}
+		}
+	}
+}
+
+func TestDecodeGeph(t *testing.T) {
+	// decoder time 2021-01-06 12:00 UTC (GPS week 2139, tow 302418)
+	now := time.Date(2021, 1, 6, 12, 0, 0, 0, time.UTC).Unix()
+	gpsday := time.Date(1980, 1, 6, 0, 0, 0, 0, time.UTC).Unix() + 2139*604800 + 3*86400
+
+	dec, err := NewDecoder()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dec.Close()
+	dec.setTime(GtimeT{Time: now + 18})
+	dec.setOpt("-EPHALL")
+
+	r := rand.New(rand.NewSource(1020))
+	for prn := uint32(1); prn <= 24; prn++ {
+		// tb and tk (local time +3h) within 12 hours of the UTC time of day
+		tb := uint32(r.Intn(96))
+		tk := uint32(r.Intn(2880))
+		frame, values := ephFrame(r, 1020, map[string]uint32{
+			"prn": prn, "tb": tb, "tk_h": tk / 120, "tk_m": tk / 2 % 60, "tk_s": tk % 2,
+		})
+		status, rtcm := dec.decodeFrame(frame)
+		if status != 2 || rtcm.EphSat != satGLO+int(prn)-1 {
+			t.Fatalf("prn %d: expected to get status %d sat %d, but got %d %d", prn, 2, satGLO+int(prn)-1, status, rtcm.EphSat)
+		}
+		var geph GephT
+		for _, g := range rtcm.Nav.Geph {
+			if g.Sat == satGLO+int(prn)-1 {
+				geph = g
+			}
+		}
+		checkEphFields(t, 1020, geph, values)
+
+		// utc time of day within 12 hours of the decoder time
+		tod := func(t int64) int64 {
+			t -= 10800 // lt -> utc
+			if t < 0 {
+				t += 86400
+			} else if t > 86400 {
+				t -= 86400
+			}
+			return t
+		}
+		toe := gpsday + tod(int64(tb)*900) + 18
+		tof := gpsday + tod(int64(tk)*30) + 18
+		frq, svh, iode := int(values["frq"])-7, int(values["bn"]), int(tb&0x7f)
+		if geph.Frq != frq || geph.Svh != svh || geph.Iode != iode || geph.Toe.Time != toe || geph.Tof.Time != tof {
+			t.Errorf("prn %d: expected to get frq %d svh %d iode %d toe %d tof %d, but got %d %d %d %d %d",
+				prn, frq, svh, iode, toe, tof, geph.Frq, geph.Svh, geph.Iode, geph.Toe.Time, geph.Tof.Time)
+		}
+	}
+}
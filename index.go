@@ -0,0 +1,190 @@
+package rtcm
+
+/*
+#include "rtkcmn.h"
+#include "rtcm.h"
+*/
+import "C"
+import (
+	"bufio"
+	"encoding/binary"
+	"errors"
+	"io"
+	"math"
+	"os"
+	"sort"
+)
+
+// IndexExt file name extension of the sidecar index file of rtcm3 log
+const IndexExt = ".idx"
+
+// indexMagic head of the index file, indexRecLen length of a index record
+const (
+	indexMagic  = "RTCMIDX1"
+	indexRecLen = 24
+	indexBatch  = 4096
+)
+
+var ErrIndexFormat = errors.New("invalid index format")
+
+// IndexEntry frame index record of rtcm3 log
+type IndexEntry struct {
+	Offset int64  // frame offset in log (bytes)
+	Len    int    // frame length (bytes)
+	Type   int    // message type
+	StaId  int    // station id (0:no station id)
+	Time   GtimeT // epoch time (GPST) (last epoch time if no epoch in message)
+}
+
+// Index frame index of rtcm3 log in log order
+type Index []IndexEntry
+
+// BuildIndex scan valid frames in rtcm3 log data and return the frame index,
+// start is a time within a half week of the log start to resolve the week
+// (zero for the current time)
+func BuildIndex(data []byte, start GtimeT) Index {
+	var idx Index
+	var consumed C.size_t
+	ctime := C.gtime_t{time: C.time_t(start.Time), sec: C.double(start.Sec)}
+	recs := make([]C.rtcm_index_t, indexBatch)
+	offset := 0
+
+	for {
+		n := int(C.scan_rtcm3(&ctime, cbytes(data[offset:]), C.size_t(len(data)-offset), &recs[0], C.int(len(recs)), &consumed))
+		for _, rec := range recs[:n] {
+			idx = append(idx, IndexEntry{
+				Offset: int64(offset) + int64(rec.offset),
+				Len:    int(rec.len),
+				Type:   int(rec._type),
+				StaId:  int(rec.staid),
+				Time: GtimeT{
+					Time: int64(rec.time.time),
+					Sec:  float64(rec.time.sec),
+				},
+			})
+		}
+		offset += int(consumed)
+		if n < len(recs) {
+			return idx
+		}
+	}
+}
+
+// IndexFile build the frame index of rtcm3 log file by memory mapping and
+// write it to the sidecar index file (path + IndexExt)
+func IndexFile(path string, start GtimeT) (Index, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+
+	data, unmap, err := mmapFile(f)
+	if err != nil {
+		return nil, err
+	}
+	idx := BuildIndex(data, start)
+	if err = unmap(); err != nil {
+		return nil, err
+	}
+
+	out, err := os.Create(path + IndexExt)
+	if err != nil {
+		return nil, err
+	}
+	if _, err = idx.WriteTo(out); err != nil {
+		out.Close()
+		return nil, err
+	}
+	return idx, out.Close()
+}
+
+// LoadIndex read the sidecar index file of rtcm3 log file
+func LoadIndex(path string) (Index, error) {
+	f, err := os.Open(path + IndexExt)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+	return ReadIndex(f)
+}
+
+// WriteTo write the index in binary format (little endian records of offset,
+// time (s), time (ms), frame length, message type and station id)
+func (idx Index) WriteTo(w io.Writer) (int64, error) {
+	bw := bufio.NewWriter(w)
+	n, err := bw.WriteString(indexMagic)
+	if err != nil {
+		return int64(n), err
+	}
+	var rec [indexRecLen]byte
+	for _, e := range idx {
+		sec, ms := e.Time.Time, math.Round(e.Time.Sec*1000.0)
+		if ms >= 1000.0 {
+			sec, ms = sec+1, ms-1000.0
+		}
+		binary.LittleEndian.PutUint64(rec[0:], uint64(e.Offset))
+		binary.LittleEndian.PutUint64(rec[8:], uint64(sec))
+		binary.LittleEndian.PutUint16(rec[16:], uint16(ms))
+		binary.LittleEndian.PutUint16(rec[18:], uint16(e.Len))
+		binary.LittleEndian.PutUint16(rec[20:], uint16(e.Type))
+		binary.LittleEndian.PutUint16(rec[22:], uint16(e.StaId))
+		m, err := bw.Write(rec[:])
+		n += m
+		if err != nil {
+			return int64(n), err
+		}
+	}
+	return int64(n), bw.Flush()
+}
+
+// ReadIndex read the index in binary format written by Index.WriteTo
+func ReadIndex(r io.Reader) (Index, error) {
+	br := bufio.NewReader(r)
+	var magic [len(indexMagic)]byte
+	if _, err := io.ReadFull(br, magic[:]); err != nil || string(magic[:]) != indexMagic {
+		return nil, ErrIndexFormat
+	}
+	var idx Index
+	var rec [indexRecLen]byte
+	for {
+		if _, err := io.ReadFull(br, rec[:]); err == io.EOF {
+			return idx, nil
+		} else if err != nil {
+			return nil, ErrIndexFormat
+		}
+		idx = append(idx, IndexEntry{
+			Offset: int64(binary.LittleEndian.Uint64(rec[0:])),
+			Len:    int(binary.LittleEndian.Uint16(rec[18:])),
+			Type:   int(binary.LittleEndian.Uint16(rec[20:])),
+			StaId:  int(binary.LittleEndian.Uint16(rec[22:])),
+			Time: GtimeT{
+				Time: int64(binary.LittleEndian.Uint64(rec[8:])),
+				Sec:  float64(binary.LittleEndian.Uint16(rec[16:])) * 0.001,
+			},
+		})
+	}
+}
+
+// Search return the position of the first entry at or after the time t,
+// the entries are assumed to be in time order as in a log
+func (idx Index) Search(t GtimeT) int {
+	return sort.Search(len(idx), func(i int) bool {
+		e := idx[i].Time
+		return e.Time > t.Time || (e.Time == t.Time && e.Sec >= t.Sec)
+	})
+}
+
+// Filter return the entries of the message types
+func (idx Index) Filter(types ...int) Index {
+	var out Index
+	for _, e := range idx {
+		for _, t := range types {
+			if e.Type == t {
+				out = append(out, e)
+				break
+			}
+		}
+	}
+	return out
+}
@@ -0,0 +1,128 @@
+package rtcm
+
+import (
+	"os"
+	"path/filepath"
+	"testing"
+)
+
+// makeFrame generate a frame with the message of the bit fields {value, bits}
+func makeFrame(fields [][2]uint32) []byte {
+	nbit := 0
+	for _, f := range fields {
+		nbit += int(f[1])
+	}
+	msg := make([]byte, (nbit+7)/8)
+	pos := 0
+	for _, f := range fields {
+		for i := int(f[1]) - 1; i >= 0; i-- {
+			if f[0]>>uint(i)&1 != 0 {
+				msg[pos/8] |= 0x80 >> uint(pos%8)
+			}
+			pos++
+		}
+	}
+	frame := append([]byte{0xd3, byte(len(msg) >> 8), byte(len(msg))}, msg...)
+	crc := crc24q(frame)
+	return append(frame, byte(crc>>16), byte(crc>>8), byte(crc))
+}
+
+// frame1004 generate a type 1004 frame with header only
+func frame1004(staid int, tow uint32) []byte {
+	return makeFrame([][2]uint32{{1004, 12}, {uint32(staid), 12}, {tow, 30}, {0, 1}, {0, 5}, {0, 4}})
+}
+
+func TestBuildIndex(t *testing.T) {
+	// gps week 2300 tow 100000.5 s
+	start := GtimeT{Time: 315964800 + 2300*604800}
+	bad := append([]byte{}, frame1005...)
+	bad[len(bad)-1] ^= 0x01
+
+	var log []byte
+	log = append(log, 0x24, 0xd3, 0xff)
+	log = append(log, frame1004(7, 100000500)...)
+	log = append(log, bad...)
+	log = append(log, frame1005...)
+
+	idx := BuildIndex(log, start)
+	if len(idx) != 2 {
+		t.Fatalf("expected to get %d entries, but got %d", 2, len(idx))
+	}
+	if idx[0].Offset != 3 || idx[0].Type != 1004 || idx[0].StaId != 7 || idx[0].Len != 14 {
+		t.Fatalf("unexpected entry %+v", idx[0])
+	}
+	if idx[1].Offset != int64(3+14+len(bad)) || idx[1].Type != 1005 {
+		t.Fatalf("unexpected entry %+v", idx[1])
+	}
+	want := GtimeT{Time: start.Time + 100000, Sec: 0.5}
+	if idx[0].Time != want || idx[1].Time != want {
+		t.Fatalf("expected to get time %+v, but got %+v %+v", want, idx[0].Time, idx[1].Time)
+	}
+	if idx.Search(want) != 0 || idx.Search(GtimeT{Time: want.Time + 1}) != 2 {
+		t.Fatalf("unexpected search result")
+	}
+	if f := idx.Filter(1005); len(f) != 1 || f[0] != idx[1] {
+		t.Fatalf("unexpected filter result %+v", f)
+	}
+}
+
+func TestBuildIndexOverrun(t *testing.T) {
+	// false preamble with the length overrunning the log between frames
+	var log []byte
+	for i := 0; i < 5; i++ {
+		log = append(log, frame1005...)
+	}
+	log = append(log, 0xd3, 0x00, 0xff)
+	for i := 0; i < 5; i++ {
+		log = append(log, frame1005...)
+	}
+	if idx := BuildIndex(log, GtimeT{}); len(idx) != 10 {
+		t.Fatalf("expected to get %d entries, but got %d", 10, len(idx))
+	}
+	// incomplete frame at the end of log
+	if idx := BuildIndex(log[:len(log)-1], GtimeT{}); len(idx) != 9 {
+		t.Fatalf("expected to get %d entries, but got %d", 9, len(idx))
+	}
+}
+
+func TestIndexFile(t *testing.T) {
+	start := GtimeT{Time: 315964800 + 2300*604800}
+	var log []byte
+	for i := 0; i < 5000; i++ {
+		log = append(log, frame1004(i%4096, uint32(i*1000))...)
+		log = append(log, frame1005...)
+	}
+	path := filepath.Join(t.TempDir(), "log.rtcm3")
+	if err := os.WriteFile(path, log, 0o644); err != nil {
+		t.Fatal(err)
+	}
+
+	idx, err := IndexFile(path, start)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(idx) != 10000 {
+		t.Fatalf("expected to get %d entries, but got %d", 10000, len(idx))
+	}
+	for _, e := range idx {
+		if !CheckCrc(log[e.Offset : e.Offset+int64(e.Len)]) {
+			t.Fatalf("unexpected entry %+v", e)
+		}
+	}
+	if i := idx.Search(GtimeT{Time: start.Time + 2500}); i != 5000 {
+		t.Fatalf("expected to get position %d, but got %d", 5000, i)
+	}
+
+	loaded, err := LoadIndex(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(loaded) != len(idx) {
+		t.Fatalf("expected to get %d entries, but got %d", len(idx), len(loaded))
+	}
+	for i := range idx {
+		if loaded[i] != idx[i] {
+			t.Fatalf("expected to get %+v, but got %+v", idx[i], loaded[i])
+		}
+	}
+}
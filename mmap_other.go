@@ -0,0 +1,17 @@
+//go:build !unix
+
+package rtcm
+
+import (
+	"io"
+	"os"
+)
+
+// mmapFile read the whole file to memory on the systems without mmap
+func mmapFile(f *os.File) ([]byte, func() error, error) {
+	data, err := io.ReadAll(f)
+	if err != nil {
+		return nil, nil, err
+	}
+	return data, func() error { return nil }, nil
+}
@@ -0,0 +1,534 @@
+package rtcm
+
+/*
+#include "rtkcmn.h"
+#include "rtcm.h"
+*/
+import "C"
+import (
+	"os"
+	"runtime"
+	"sync"
+	"unsafe"
+)
+
+const (
+	parallelOverlap  = 2.0     // warm-up overlap before a chunk (s)
+	parallelChunkMin = 1 << 20 // min chunk size (bytes)
+	parallelChunks   = 4       // number of chunks per worker
+	lockUnknown      = 0xFFFF  // lock time of satellite not decoded in a chunk
+)
+
+// scanRec frame record of the chunk scan
+type scanRec struct {
+	off  int64     // frame offset (bytes)
+	n    int       // frame length (bytes)
+	typ  int       // message type
+	seq  int       // frame sequence number in the chunk
+	tsys int       // epoch time system (0:no epoch,1:GPST tow,2:GLONASS tod)
+	tow  float64   // epoch time of week or day (s)
+	ref  C.gtime_t // reference time before the frame
+	time C.gtime_t // reference time after the frame
+}
+
+// chunkScan frame records of a chunk of the log, the times of the frames are
+// resolved from the log start time until fixed up by the previous chunk
+type chunkScan struct {
+	end   int64     // chunk end offset (bytes)
+	first int64     // offset of the first frame (-1:no frame)
+	next  int64     // offset of the first frame after the chunk (-1:no frame)
+	pre   []scanRec // frames before and including the first GPST frame
+	state []scanRec // state frames after the first GPST frame
+	tail  []scanRec // frames in the warm-up overlap at the chunk end
+	last  C.gtime_t // reference time after the last frame
+	shift int64     // week shift of the times after the first GPST frame (s)
+}
+
+// navState snapshot of the decoding state carried by state messages
+type navState struct {
+	eph    []C.eph_t
+	geph   []C.geph_t
+	gloFcn [32]C.int
+	sta    C.sta_t
+	ssr    [C.MAXSAT]C.ssr_t
+	msg    [128]C.char
+	ephSat C.int
+	ephSet C.int
+}
+
+// lockFix loss-of-lock indicator decoded without the lock time before a chunk
+type lockFix struct {
+	out  int       // output message index
+	data int       // observation data index
+	sat  int       // satellite number
+	time C.gtime_t // observation time
+	freq int       // frequency index
+	lock uint16    // lock time indicator
+	warm bool      // decoded in the warm-up overlap
+}
+
+// chunkResult decoded messages of a chunk
+type chunkResult struct {
+	rtcms []Rtcm
+	fixes []lockFix
+	lock  [C.MAXSAT][C.NFREQ + C.NEXOBS]C.uint16_t
+	tail  *[C.MAXSAT][C.NFREQ + C.NEXOBS]C.uint16_t // lock time before the tail
+}
+
+// DecodeParallel decode rtcm3 log data on multiple goroutines and return the
+// messages in log order as Decoder.Input with the whole data, start is a time
+// within a half week of the log start to resolve the week (zero for the
+// current time), workers is the number of goroutines (0 for GOMAXPROCS).
+// The log is split into chunks decoded with their own decoding states: epoch
+// times, ephemerides, station and ssr parameters and loss-of-lock indicators
+// and the GLONASS frequency channels are carried over the chunks. Observation
+// data of an epoch and the carrier-phase rollover of type 1001-1012 are
+// carried by decoding the frames of the last 2 s before the chunk.
+func DecodeParallel(data []byte, start GtimeT, workers int) []Rtcm {
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	size := len(data) / (workers * parallelChunks)
+	if size < parallelChunkMin {
+		size = parallelChunkMin
+	}
+	return decodeParallel(data, start, workers, size)
+}
+
+// DecodeFileParallel decode rtcm3 log file by memory mapping with
+// DecodeParallel
+func DecodeFileParallel(path string, start GtimeT, workers int) ([]Rtcm, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+
+	data, unmap, err := mmapFile(f)
+	if err != nil {
+		return nil, err
+	}
+	rtcms := DecodeParallel(data, start, workers)
+	return rtcms, unmap()
+}
+
+// decodeParallel decode rtcm3 log data by chunks of size bytes
+func decodeParallel(data []byte, start GtimeT, workers, size int) []Rtcm {
+	ctime := C.gtime_t{time: C.time_t(start.Time), sec: C.double(start.Sec)}
+	nchunk := (len(data) + size - 1) / size
+	chunks := make([]*chunkScan, nchunk)
+
+	// scan the chunks resynchronized on a frame
+	parallelFor(nchunk, workers, func(k int) {
+		end := int64(k+1) * int64(size)
+		if end > int64(len(data)) {
+			end = int64(len(data))
+		}
+		chunks[k] = scanChunk(data, int64(k)*int64(size), end, ctime)
+	})
+	fixChunks(data, chunks, ctime)
+
+	// decode the state frames in log order for the chunk states
+	states := make([]chan *navState, nchunk)
+	for k := range states {
+		states[k] = make(chan *navState, 1)
+	}
+	go decodeStates(data, chunks, states)
+
+	results := make([]*chunkResult, nchunk)
+	parallelFor(nchunk, workers, func(k int) {
+		results[k] = decodeChunk(data, chunks, k, <-states[k])
+	})
+	return mergeResults(results)
+}
+
+// parallelFor call fn(0)...fn(n-1) on the worker goroutines
+func parallelFor(n, workers int, fn func(k int)) {
+	jobs := make(chan int)
+	var wg sync.WaitGroup
+	for i := 0; i < workers; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for k := range jobs {
+				fn(k)
+			}
+		}()
+	}
+	for k := 0; k < n; k++ {
+		jobs <- k
+	}
+	close(jobs)
+	wg.Wait()
+}
+
+// scanChunk scan the frames starting in the chunk from the offset from to end
+func scanChunk(data []byte, from, end int64, start C.gtime_t) *chunkScan {
+	c := &chunkScan{end: end, first: -1, last: start}
+	ctime, anchor, seq := start, false, 0
+
+	c.next = scanFrames(data, from, end, &ctime, func(off int64, rec *C.rtcm_index_t) {
+		r := scanRec{
+			off:  off,
+			n:    int(rec.len),
+			typ:  int(rec._type),
+			seq:  seq,
+			tsys: int(rec.tsys),
+			tow:  float64(rec.tow),
+			ref:  c.last,
+			time: rec.time,
+		}
+		if c.first < 0 {
+			c.first = r.off
+		}
+		if !anchor {
+			c.pre = append(c.pre, r)
+			anchor = r.tsys == 1
+		} else if isStateType(r.typ) {
+			c.state = append(c.state, r)
+		}
+		// frames before the first GPST frame are trimmed out of the tail by
+		// the time of the GPST frame until their times are fixed up
+		c.tail = append(c.tail, r)
+		for anchor {
+			t := c.tail[0].time
+			if c.tail[0].seq < len(c.pre) {
+				t = c.pre[len(c.pre)-1].time
+			}
+			if timeDiff(r.time, t) <= parallelOverlap {
+				break
+			}
+			c.tail = c.tail[1:]
+		}
+		c.last = r.time
+		seq++
+	})
+	return c
+}
+
+// scanFrames call fn for the valid frames starting from the offset from to
+// end and return the offset of the first frame after end (-1:no frame)
+func scanFrames(data []byte, from, end int64, ctime *C.gtime_t, fn func(off int64, rec *C.rtcm_index_t)) int64 {
+	recs := make([]C.rtcm_index_t, indexBatch)
+	var consumed C.size_t
+
+	for pos := from; ; pos += int64(consumed) {
+		n := int(C.scan_rtcm3(ctime, cbytes(data[pos:]), C.size_t(int64(len(data))-pos), &recs[0], C.int(len(recs)), &consumed))
+		for i := range recs[:n] {
+			off := pos + int64(recs[i].offset)
+			if off >= end {
+				return off
+			}
+			fn(off, &recs[i])
+		}
+		if n < len(recs) {
+			return -1
+		}
+	}
+}
+
+// fixChunks rescan the chunks not synchronized to the previous chunk, fix up
+// the week and day rollover of the times by the previous chunk in order and
+// trim the frames before the first GPST frame out of the warm-up overlap
+func fixChunks(data []byte, chunks []*chunkScan, start C.gtime_t) {
+	ref := start
+	for k, c := range chunks {
+		if k > 0 && c.first != chunks[k-1].next {
+			from := chunks[k-1].next
+			if from < 0 {
+				from = c.end
+			}
+			c = scanChunk(data, from, c.end, start)
+			chunks[k] = c
+		}
+		for i := range c.pre {
+			r := &c.pre[i]
+			r.ref = ref
+			if r.tsys > 0 {
+				t := C.resolve_rtcm3(ref, C.int(r.tsys), C.double(r.tow))
+				if r.tsys == 1 {
+					c.shift = int64(t.time - r.time.time)
+				}
+				ref = t
+			}
+			r.time = ref
+		}
+		if len(c.pre) > 0 && c.pre[len(c.pre)-1].tsys == 1 {
+			ref = shiftTime(c.last, c.shift)
+		}
+		c.last = ref
+		for len(c.tail) > 0 && c.tail[0].seq < len(c.pre) &&
+			timeDiff(ref, c.pre[c.tail[0].seq].time) > parallelOverlap {
+			c.tail = c.tail[1:]
+		}
+	}
+}
+
+// refTime return the fixed reference time before the frame of the chunk
+func (c *chunkScan) refTime(r *scanRec) C.gtime_t {
+	if r.seq < len(c.pre) {
+		return c.pre[r.seq].ref
+	}
+	return shiftTime(r.ref, c.shift)
+}
+
+// warmup return the chunk with the frames of the warm-up overlap before the
+// chunk in the tail (nil: no warm-up)
+func warmup(chunks []*chunkScan, k int) *chunkScan {
+	if k == 0 || chunks[k].first < 0 {
+		return nil
+	}
+	for j := k - 1; j >= 0; j-- {
+		if len(chunks[j].tail) > 0 {
+			return chunks[j]
+		}
+	}
+	return nil
+}
+
+// stateRecs return the state frames of the chunk in log order
+func (c *chunkScan) stateRecs() []*scanRec {
+	var recs []*scanRec
+	for i := range c.pre {
+		if isStateType(c.pre[i].typ) {
+			recs = append(recs, &c.pre[i])
+		}
+	}
+	for i := range c.state {
+		recs = append(recs, &c.state[i])
+	}
+	return recs
+}
+
+// decodeStates decode the state frames in log order and send the decoding
+// state at the warm-up start of each chunk
+func decodeStates(data []byte, chunks []*chunkScan, states []chan *navState) {
+	ctx := (*C.rtcm_t)(C.calloc(1, C.sizeof_rtcm_t))
+	defer C.free(unsafe.Pointer(ctx))
+	C.init_rtcm(ctx)
+	defer C.free_rtcm(ctx)
+
+	j, cur, recs := 0, (*chunkScan)(nil), []*scanRec(nil)
+	for k := range chunks {
+		from := chunks[k].first
+		if w := warmup(chunks, k); w != nil {
+			from = w.tail[0].off
+		}
+		for from >= 0 {
+			if len(recs) == 0 {
+				if j > k {
+					break
+				}
+				cur, recs = chunks[j], chunks[j].stateRecs()
+				j++
+				continue
+			}
+			if recs[0].off >= from {
+				break
+			}
+			ctx.time = cur.refTime(recs[0])
+			C.decode_rtcm3_frame(ctx, cbytes(data[recs[0].off:]), C.int(recs[0].n))
+			recs = recs[1:]
+		}
+		states[k] <- saveState(ctx)
+	}
+}
+
+// decodeChunk decode the frames of the chunk from the decoding state
+func decodeChunk(data []byte, chunks []*chunkScan, k int, state *navState) *chunkResult {
+	c := chunks[k]
+	res := &chunkResult{}
+	for i := range res.lock {
+		for j := range res.lock[i] {
+			res.lock[i][j] = lockUnknown
+		}
+	}
+	if c.first < 0 {
+		return res
+	}
+	ctx := (*C.rtcm_t)(C.calloc(1, C.sizeof_rtcm_t))
+	defer C.free(unsafe.Pointer(ctx))
+	C.init_rtcm(ctx)
+	defer C.free_rtcm(ctx)
+
+	loadState(ctx, state)
+	ctx.lock = res.lock
+
+	// loss-of-lock indicators decoded without the lock time before the chunk
+	// or the warm-up are fixed up with the lock time of the previous chunks
+	var unknown [C.MAXSAT][C.NFREQ + C.NEXOBS]bool
+	for i := range unknown {
+		for j := range unknown[i] {
+			unknown[i][j] = true
+		}
+	}
+	var active []lockFix
+	decode := func(off int64, size C.int, warm bool) {
+		if len(c.tail) > 0 && off == c.tail[0].off {
+			tail := ctx.lock
+			res.tail = &tail
+		}
+		status := int(C.decode_rtcm3_frame(ctx, cbytes(data[off:]), size))
+		for _, d := range unsafe.Slice(ctx.obs.data, ctx.obs.n) {
+			if d.sat <= 0 {
+				continue
+			}
+			for j := range unknown[d.sat-1] {
+				if unknown[d.sat-1][j] && ctx.lock[d.sat-1][j] != lockUnknown {
+					unknown[d.sat-1][j] = false
+					active = append(active, lockFix{sat: int(d.sat), time: d.time, freq: j, lock: uint16(ctx.lock[d.sat-1][j]), warm: warm})
+				}
+			}
+		}
+		if status <= 0 || warm {
+			return
+		}
+		res.rtcms = append(res.rtcms, convertRtcm(ctx))
+		obs := unsafe.Slice(ctx.obs.data, ctx.obs.n)
+		n := 0
+		for _, f := range active {
+			for i, d := range obs {
+				if int(d.sat) == f.sat && d.time == f.time {
+					f.out, f.data = len(res.rtcms)-1, i
+					res.fixes = append(res.fixes, f)
+					active[n] = f
+					n++
+					break
+				}
+			}
+		}
+		active = active[:n]
+	}
+	if w := warmup(chunks, k); w != nil {
+		ctx.time = w.refTime(&w.tail[0])
+		for _, r := range w.tail {
+			decode(r.off, C.int(r.n), true)
+		}
+	}
+	ctx.time = c.pre[0].ref
+	ctime := ctx.time
+	scanFrames(data, c.first, c.end, &ctime, func(off int64, rec *C.rtcm_index_t) {
+		decode(off, rec.len, false)
+	})
+	res.lock = ctx.lock
+	return res
+}
+
+// mergeResults fix up the loss-of-lock indicators by the lock time of the
+// previous chunks and return the messages of the chunks in order
+func mergeResults(results []*chunkResult) []Rtcm {
+	var lock, tail [C.MAXSAT][C.NFREQ + C.NEXOBS]C.uint16_t
+	var rtcms []Rtcm
+	for _, res := range results {
+		for _, f := range res.fixes {
+			prev := uint16(lock[f.sat-1][f.freq])
+			if f.warm {
+				prev = uint16(tail[f.sat-1][f.freq])
+			}
+			lli := &res.rtcms[f.out].Obs.Data[f.data].LLI[f.freq]
+			*lli -= uint8(b2i(f.lock < lockUnknown))
+			*lli += uint8(b2i((f.lock == 0 && prev == 0) || f.lock < prev))
+		}
+		// lock time before the warm-up overlap of the next chunk
+		if res.tail != nil {
+			tail = lock
+			for i := range res.tail {
+				for j, l := range res.tail[i] {
+					if l != lockUnknown {
+						tail[i][j] = l
+					}
+				}
+			}
+		}
+		for i := range res.lock {
+			for j, l := range res.lock[i] {
+				if l != lockUnknown {
+					lock[i][j] = l
+				}
+			}
+		}
+		rtcms = append(rtcms, res.rtcms...)
+	}
+	return rtcms
+}
+
+// saveState save the decoding state carried by state messages
+func saveState(ctx *C.rtcm_t) *navState {
+	s := &navState{
+		eph:    make([]C.eph_t, ctx.nav.n),
+		geph:   make([]C.geph_t, ctx.nav.ng),
+		gloFcn: ctx.nav.glo_fcn,
+		sta:    ctx.sta,
+		ssr:    ctx.ssr,
+		msg:    ctx.msg,
+		ephSat: ctx.ephsat,
+		ephSet: ctx.ephset,
+	}
+	copy(s.eph, unsafe.Slice(ctx.nav.eph, ctx.nav.n))
+	copy(s.geph, unsafe.Slice(ctx.nav.geph, ctx.nav.ng))
+	return s
+}
+
+// loadState load the decoding state carried by state messages
+func loadState(ctx *C.rtcm_t, s *navState) {
+	copy(unsafe.Slice(ctx.nav.eph, ctx.nav.n), s.eph)
+	copy(unsafe.Slice(ctx.nav.geph, ctx.nav.ng), s.geph)
+	ctx.nav.glo_fcn = s.gloFcn
+	ctx.sta = s.sta
+	ctx.ssr = s.ssr
+	ctx.msg = s.msg
+	ctx.ephsat = s.ephSat
+	ctx.ephset = s.ephSet
+}
+
+// msgClasses message classes of the message types (C.MSGF_???) by the
+// message type descriptors of C.get_rtcm_class
+var msgClasses = struct {
+	once  sync.Once
+	class [4096]uint8
+}{}
+
+// msgClass get the message class of the message type (C.MSGF_???)
+func msgClass(typ int) int {
+	msgClasses.once.Do(func() {
+		for i := range msgClasses.class {
+			msgClasses.class[i] = uint8(C.get_rtcm_class(C.int(i)))
+		}
+	})
+	if typ < 0 || typ >= len(msgClasses.class) {
+		return 0
+	}
+	return int(msgClasses.class[typ])
+}
+
+// isObsType test whether the message type is observation (C.MSGF_OBS)
+func isObsType(typ int) bool {
+	return msgClass(typ)&C.MSGF_OBS != 0
+}
+
+// isStateType test whether the message type carries the decoding state:
+// non-observation and GLONASS observation with the frequency channel
+// (C.MSGF_FCN)
+func isStateType(typ int) bool {
+	class := msgClass(typ)
+	return class&C.MSGF_OBS == 0 || class&C.MSGF_FCN != 0
+}
+
+// timeDiff return the difference of the times t1-t2 (s)
+func timeDiff(t1, t2 C.gtime_t) float64 {
+	return float64(t1.time-t2.time) + float64(t1.sec-t2.sec)
+}
+
+// shiftTime shift the time by the seconds
+func shiftTime(t C.gtime_t, sec int64) C.gtime_t {
+	t.time += C.time_t(sec)
+	return t
+}
+
+// b2i convert bool to int
+func b2i(b bool) int {
+	if b {
+		return 1
+	}
+	return 0
+}
@@ -0,0 +1,204 @@
+package rtcm
+
+import (
+	"math/rand"
+	"reflect"
+	"testing"
+	"time"
+)
+
+// frame1004obs generate a type 1004 frame of the satellites with the lock
+// time indicators
+func frame1004obs(tow uint32, prns []uint32, locks []uint32) []byte {
+	fields := [][2]uint32{{1004, 12}, {1, 12}, {tow, 30}, {0, 1}, {uint32(len(prns)), 5}, {0, 1}, {0, 3}}
+	for i, prn := range prns {
+		pr := 1000000 + prn*1000 + tow%1000
+		fields = append(fields, [][2]uint32{
+			{prn, 6}, {0, 1}, {pr, 24}, {0, 20}, {locks[i], 7}, {70, 8}, {180, 8},
+			{0, 2}, {0, 14}, {0, 20}, {locks[i], 7}, {160, 8},
+		}...)
+	}
+	return makeFrame(fields)
+}
+
+// frameMSMGlo generate a GLONASS MSM4 or MSM7 (type 1084 or 1087) frame of
+// the slots with the signals 1C and 2C
+func frameMSMGlo(msm int, tod uint32, slots, fcns []uint32, locks [][2]uint32) []byte {
+	var mask uint32
+	for _, slot := range slots {
+		mask |= 1 << (32 - slot)
+	}
+	fields := [][2]uint32{
+		{uint32(1080 + msm), 12}, {1, 12}, {0, 3}, {tod, 27}, {1, 1}, {0, 3}, {0, 7},
+		{0, 2}, {0, 2}, {0, 1}, {0, 3}, {mask, 32}, {0, 32}, {1<<30 | 1<<24, 32},
+		{1<<(2*len(slots)) - 1, uint32(2 * len(slots))},
+	}
+	for _, slot := range slots {
+		fields = append(fields, [2]uint32{70 + slot, 8})
+	}
+	if msm == 7 {
+		for i := range slots {
+			fields = append(fields, [2]uint32{fcns[i] + 7, 4})
+		}
+	}
+	for range slots {
+		fields = append(fields, [2]uint32{tod % 1000, 10})
+	}
+	if msm == 7 {
+		for range slots {
+			fields = append(fields, [2]uint32{100, 14})
+		}
+	}
+	bits := map[int][5]uint32{4: {15, 22, 4, 1, 6}, 7: {20, 24, 10, 1, 10}}[msm]
+	for i, v := range []uint32{1000, 2000 + tod%1000, 0, 0, 40} {
+		for j := range slots {
+			for k := 0; k < 2; k++ {
+				if i == 2 {
+					v = locks[j][k]
+					if v >= 1<<bits[i] {
+						v = 1<<bits[i] - 1
+					}
+				}
+				fields = append(fields, [2]uint32{v, bits[i]})
+			}
+		}
+	}
+	if msm == 7 {
+		fields = append(fields, [2]uint32{0, uint32(15 * 2 * len(slots))})
+	}
+	return makeFrame(fields)
+}
+
+// frame1019 generate a type 1019 frame of the GPS ephemeris
+func frame1019(prn, week, iode, toes uint32) []byte {
+	return makeFrame([][2]uint32{
+		{1019, 12}, {prn, 6}, {week, 10}, {0, 4}, {0, 2}, {0, 14}, {iode, 8},
+		{toes, 16}, {0, 8}, {0, 16}, {0, 22}, {iode, 10}, {0, 16}, {0, 16},
+		{0, 32}, {0, 16}, {0, 32}, {0, 16}, {2702030000, 32}, {toes, 16},
+		{0, 16}, {0, 32}, {0, 16}, {0, 32}, {0, 16}, {0, 32}, {0, 24}, {0, 8},
+		{0, 6}, {0, 1}, {0, 1},
+	})
+}
+
+// frame1020 generate a type 1020 frame of the GLONASS ephemeris of the time
+// of day and the index of the ephemeris time (15 min)
+func frame1020(slot, fcn, tod, tb uint32) []byte {
+	return makeFrame([][2]uint32{
+		{1020, 12}, {slot, 6}, {fcn + 7, 5}, {0, 4}, {tod / 3600, 5},
+		{tod / 60 % 60, 6}, {tod % 60 / 30, 1}, {0, 2}, {tb, 7}, {0, 168},
+		{0, 47}, {0, 97},
+	})
+}
+
+// parallelLog generate a log of the epochs from the GPS time of week (s) with
+// type 1004 and GLONASS MSM observations, 1019, 1020 and 1005 messages
+func parallelLog(rnd *rand.Rand, tow0 uint32, n int) []byte {
+	week := uint32((time.Now().Unix()-315964800)/604800) % 1024
+	fcns := []uint32{1, 2, 3, 4, 5, 6} // fcn+7 of the slots 1-6
+	var log []byte
+	var lock [32]uint32
+	var glock [7][2]uint32
+	for i := 0; i < n; i++ {
+		tow := (tow0 + uint32(i)) % 604800
+		tod := (tow + 604800 - 18 + 10800) % 86400
+
+		// GLONASS MSM7 with the frequency channels every 25 epochs
+		var slots, fcn []uint32
+		var glocks [][2]uint32
+		for slot := uint32(1); slot <= 6; slot++ {
+			if (i/int(slot+5))%5 == 4 {
+				continue
+			}
+			for k := range glock[slot] {
+				if rnd.Intn(30) == 0 {
+					glock[slot][k] = 0
+				} else {
+					glock[slot][k]++
+				}
+			}
+			slots, fcn = append(slots, slot), append(fcn, fcns[slot-1]-7)
+			glocks = append(glocks, glock[slot])
+		}
+		msm := 4
+		if i%25 == 3 {
+			msm = 7
+		}
+		log = append(log, frameMSMGlo(msm, tod*1000, slots, fcn, glocks)...)
+
+		var prns, locks []uint32
+		for prn := uint32(1); prn <= 12; prn++ {
+			// satellites out of view for several epochs and lock resets
+			if (i/int(prn+3))%4 == 3 {
+				continue
+			}
+			if rnd.Intn(20) == 0 {
+				lock[prn] = 0
+			} else if lock[prn] < 127 {
+				lock[prn]++
+			}
+			prns, locks = append(prns, prn), append(locks, lock[prn])
+		}
+		log = append(log, frame1004obs(tow*1000, prns, locks)...)
+
+		// GPS ephemerides, GLONASS ephemerides of the slots 1-3 only
+		if prn := uint32(i%30) / 5; 1 <= prn && prn <= 4 {
+			log = append(log, frame1019(prn, week, uint32(i/30)+prn, tow/16)...)
+		}
+		if slot := uint32(i%30) - 15; 1 <= slot && slot <= 3 {
+			log = append(log, frame1020(slot, fcns[slot-1]-7, tod, uint32(i/30))...)
+		}
+		if i%10 == 0 {
+			log = append(log, frame1005...)
+			log = append(log, 0xd3, 0x00)
+		}
+	}
+	return log
+}
+
+func TestDecodeParallel(t *testing.T) {
+	rnd := rand.New(rand.NewSource(1))
+	logs := map[string][]byte{
+		"gps week": parallelLog(rnd, 604800-150, 300),
+		// glonass day rollover at gpst 21:00:18
+		"glonass day": parallelLog(rnd, 3*86400-10800+18-150, 300),
+	}
+	for name, log := range logs {
+		dec, err := NewDecoder()
+		if err != nil {
+			t.Fatal(err)
+		}
+		want := dec.Input(log)
+		dec.Close()
+
+		// chunks of over the warm-up overlap (2 s) splitting the ephemerides
+		// and the MSM7 from the observations
+		for _, size := range []int{len(log), 5000, 2000, 1500} {
+			got := decodeParallel(log, GtimeT{}, 4, size)
+			if len(got) != len(want) {
+				t.Fatalf("%s size %d: expected to get %d messages, but got %d", name, size, len(want), len(got))
+			}
+			for i := range want {
+				if !reflect.DeepEqual(got[i], want[i]) {
+					t.Fatalf("%s size %d: message %d (type %d) differs", name, size, i, want[i].Type)
+				}
+			}
+		}
+	}
+}
+
+func TestMsgClass(t *testing.T) {
+	cases := []struct {
+		typ        int
+		obs, state bool
+	}{
+		{1004, true, false}, {1010, true, true}, {1012, true, true}, {1074, true, false},
+		{1081, true, false}, {1085, true, true}, {1086, true, false}, {1087, true, true},
+		{1137, true, false}, {1005, false, true}, {1019, false, true}, {1060, false, true},
+		{1138, false, true}, {4076, false, true}, {-1, false, true}, {4096, false, true},
+	}
+	for _, c := range cases {
+		if obs, state := isObsType(c.typ), isStateType(c.typ); obs != c.obs || state != c.state {
+			t.Fatalf("type %d: expected to get obs %v state %v, but got %v %v", c.typ, c.obs, c.state, obs, state)
+		}
+	}
+}
@@ -50,12 +50,17 @@
 *-----------------------------------------------------------------------------*/
 #include "rtcm.h"
 #include "rtkcmn.h"
+#if defined(__GNUC__)&&defined(__x86_64__)
+#define MSM_AVX2                /* msm cell unpacking by avx2 (runtime dispatch) */
+#include <immintrin.h>
+#endif
 
 /* constants -----------------------------------------------------------------*/
 
 #define PRUNIT_GPS  299792.458  /* rtcm ver.3 unit of gps pseudorange (m) */
 #define PRUNIT_GLO  599584.916  /* rtcm ver.3 unit of glonass pseudorange (m) */
 #define RANGE_MS    (CLIGHT*0.001)      /* range in 1 ms */
+#define MAXNMEA     82          /* max length of NMEA sentence (bytes) */
 
 #define P2_10       0.0009765625          /* 2^-10 */
 #define P2_28       3.725290298461914E-09 /* 2^-28 */
@@ -75,53 +80,76 @@ typedef struct {              /* multi-signal-message header type */
     uint8_t smooth;           /* divergence free smoothing indicator */
     uint8_t tint_s;           /* soothing interval */
     uint8_t nsat,nsig;        /* number of satellites/signals */
+    uint32_t sigmask;         /* signal mask (msb: signal id 1) */
     uint8_t sats[64];         /* satellites */
     uint8_t sigs[32];         /* signals */
     uint8_t cellmask[64];     /* cell mask */
 } msm_h_t;
 
+typedef struct {              /* multi-signal-message data fields type */
+    int rng[64],rng_m[64];    /* rough range (ms,2^-10 ms) */
+    int ex[64],rate[64];      /* extended info, rough phaserangerate (MSM 5,7) */
+    int pr[64],cp[64],rrf[64]; /* fine pseudorange, phaserange, phaserangerate */
+    int lock[64],half[64];    /* lock time, half-cycle ambiguity indicator */
+    int cnr[64];              /* signal cnr */
+} msm_d_t;
+
+typedef struct {              /* bit reader type */
+    const uint8_t *p;         /* next byte to load */
+    const uint8_t *end;       /* end of message */
+    uint64_t reg;             /* bit register (next bit at msb) */
+    int nbit;                 /* number of bits loaded in register */
+} bitrd_t;
+
 /* MSM signal ID table -------------------------------------------------------*/
-const char *msm_sig_gps[32]={
+const uint8_t msm_sig_gps[32]={
     /* GPS: ref [17] table 3.5-91 */
-    ""  ,"1C","1P","1W",""  ,""  ,""  ,"2C","2P","2W",""  ,""  , /*  1-12 */
-    ""  ,""  ,"2S","2L","2X",""  ,""  ,""  ,""  ,"5I","5Q","5X", /* 13-24 */
-    ""  ,""  ,""  ,""  ,""  ,"1S","1L","1X"                      /* 25-32 */
+           0,CODE_L1C,CODE_L1P,CODE_L1W,       0,       0,       0,CODE_L2C,
+    CODE_L2P,CODE_L2W,       0,       0,       0,       0,CODE_L2S,CODE_L2L,
+    CODE_L2X,       0,       0,       0,       0,CODE_L5I,CODE_L5Q,CODE_L5X,
+           0,       0,       0,       0,       0,CODE_L1S,CODE_L1L,CODE_L1X
 };
-const char *msm_sig_glo[32]={
+const uint8_t msm_sig_glo[32]={
     /* GLONASS: ref [17] table 3.5-96 */
-    ""  ,"1C","1P",""  ,""  ,""  ,""  ,"2C","2P",""  ,""  ,""  ,
-    ""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,
-    ""  ,""  ,""  ,""  ,""  ,""  ,""  ,""
+           0,CODE_L1C,CODE_L1P,       0,       0,       0,       0,CODE_L2C,
+    CODE_L2P,       0,       0,       0,       0,       0,       0,       0,
+           0,       0,       0,       0,       0,       0,       0,       0,
+           0,       0,       0,       0,       0,       0,       0,       0
 };
-const char *msm_sig_gal[32]={
-    /* Galileo: ref [17] table 3.5-99 */
-    ""  ,"1C","1A","1B","1X","1Z",""  ,"6C","6A","6B","6X","6Z",
-    ""  ,"7I","7Q","7X",""  ,"8I","8Q","8X",""  ,"5I","5Q","5X",
-    ""  ,""  ,""  ,""  ,""  ,""  ,""  ,""
+const uint8_t msm_sig_gal[32]={
+    /* Galileo: ref [17] table 3.5-99 (8I: no obs code in obscodes[]) */
+           0,CODE_L1C,CODE_L1A,CODE_L1B,CODE_L1X,CODE_L1Z,       0,CODE_L6C,
+    CODE_L6A,CODE_L6B,CODE_L6X,CODE_L6Z,       0,CODE_L7I,CODE_L7Q,CODE_L7X,
+           0,       0,CODE_L8Q,CODE_L8X,       0,CODE_L5I,CODE_L5Q,CODE_L5X,
+           0,       0,       0,       0,       0,       0,       0,       0
 };
-const char *msm_sig_qzs[32]={
+const uint8_t msm_sig_qzs[32]={
     /* QZSS: ref [17] table 3.5-105 */
-    ""  ,"1C",""  ,""  ,""  ,""  ,""  ,""  ,"6S","6L","6X",""  ,
-    ""  ,""  ,"2S","2L","2X",""  ,""  ,""  ,""  ,"5I","5Q","5X",
-    ""  ,""  ,""  ,""  ,""  ,"1S","1L","1X"
+           0,CODE_L1C,       0,       0,       0,       0,       0,       0,
+    CODE_L6S,CODE_L6L,CODE_L6X,       0,       0,       0,CODE_L2S,CODE_L2L,
+    CODE_L2X,       0,       0,       0,       0,CODE_L5I,CODE_L5Q,CODE_L5X,
+           0,       0,       0,       0,       0,CODE_L1S,CODE_L1L,CODE_L1X
 };
-const char *msm_sig_sbs[32]={
+const uint8_t msm_sig_sbs[32]={
     /* SBAS: ref [17] table 3.5-102 */
-    ""  ,"1C",""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,
-    ""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,"5I","5Q","5X",
-    ""  ,""  ,""  ,""  ,""  ,""  ,""  ,""
+           0,CODE_L1C,       0,       0,       0,       0,       0,       0,
+           0,       0,       0,       0,       0,       0,       0,       0,
+           0,       0,       0,       0,       0,CODE_L5I,CODE_L5Q,CODE_L5X,
+           0,       0,       0,       0,       0,       0,       0,       0
 };
-const char *msm_sig_cmp[32]={
+const uint8_t msm_sig_cmp[32]={
     /* BeiDou: ref [17] table 3.5-108 */
-    ""  ,"2I","2Q","2X",""  ,""  ,""  ,"6I","6Q","6X",""  ,""  ,
-    ""  ,"7I","7Q","7X",""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,
-    ""  ,""  ,""  ,""  ,""  ,""  ,""  ,""
+           0,CODE_L2I,CODE_L2Q,CODE_L2X,       0,       0,       0,CODE_L6I,
+    CODE_L6Q,CODE_L6X,       0,       0,       0,CODE_L7I,CODE_L7Q,CODE_L7X,
+           0,       0,       0,       0,       0,       0,       0,       0,
+           0,       0,       0,       0,       0,       0,       0,       0
 };
-const char *msm_sig_irn[32]={
+const uint8_t msm_sig_irn[32]={
     /* NavIC/IRNSS: ref [17] table 3.5-108.3 */
-    ""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,
-    ""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,"5A",""  ,""  ,
-    ""  ,""  ,""  ,""  ,""  ,""  ,""  ,""
+           0,       0,       0,       0,       0,       0,       0,       0,
+           0,       0,       0,       0,       0,       0,       0,       0,
+           0,       0,       0,       0,       0,CODE_L5A,       0,       0,
+           0,       0,       0,       0,       0,       0,       0,       0
 };
 /* SSR signal and tracking mode IDs ------------------------------------------*/
 const uint8_t ssr_sig_gps[32]={
@@ -154,24 +182,185 @@ const uint8_t ssr_sig_sbs[32]={
 static const double ssrudint[16]={
     1,2,5,10,15,30,60,120,240,300,600,900,1800,3600,7200,10800
 };
-/* get sign-magnitude bits ---------------------------------------------------*/
-static double getbitg(const uint8_t *buff, int pos, int len)
+/* load bytes to bit register -------------------------------------------------
+* an 8-byte big-endian word is loaded while 8 bytes are left in the message, the
+* bits below the loaded bytes are equal to the next bytes and reloaded by OR
+*-----------------------------------------------------------------------------*/
+static void fill_bitrd(bitrd_t *rd)
+{
+    const uint8_t *p=rd->p;
+    uint64_t w;
+    int n;
+
+    if (rd->end-p>=8) {
+        w=(uint64_t)p[0]<<56|(uint64_t)p[1]<<48|(uint64_t)p[2]<<40|
+          (uint64_t)p[3]<<32|(uint64_t)p[4]<<24|(uint64_t)p[5]<<16|
+          (uint64_t)p[6]<< 8|p[7];
+        n=(63-rd->nbit)/8;
+        rd->reg|=w>>rd->nbit;
+        rd->p+=n;
+        rd->nbit+=n*8;
+        return;
+    }
+    for (;rd->nbit<=56&&p<rd->end;p++,rd->nbit+=8) {
+        rd->reg|=(uint64_t)*p<<(56-rd->nbit);
+    }
+    rd->p=p;
+}
+/* read unsigned bits by bit reader --------------------------------------------
+* args   : bitrd_t *rd      IO  bit reader
+*          int    len       I   bit length (bits) (len<=32)
+* return : unsigned bits
+* notes  : bits beyond the end of message are read as 0
+*-----------------------------------------------------------------------------*/
+static uint32_t rdbitu(bitrd_t *rd, int len)
 {
-    double value=getbitu(buff,pos+1,len-1);
-    return getbitu(buff,pos,1)?-value:value;
+    uint32_t bits;
+
+    if (len<=0) return 0;
+    if (rd->nbit<len) fill_bitrd(rd);
+    bits=(uint32_t)(rd->reg>>(64-len));
+    rd->reg<<=len;
+    rd->nbit-=len;
+    return bits;
 }
-/* adjust weekly rollover of GPS time ----------------------------------------*/
-static void adjweek(rtcm_t *rtcm, double tow)
+/* read signed bits by bit reader --------------------------------------------*/
+static int32_t rdbits(bitrd_t *rd, int len)
+{
+    uint32_t bits=rdbitu(rd,len),sign;
+    if (len<=0||32<=len) return (int32_t)bits;
+    sign=1u<<(len-1);
+    return (int32_t)(bits^sign)-(int32_t)sign; /* extend sign */
+}
+/* read sign-magnitude bits by bit reader ------------------------------------*/
+static double rdbitg(bitrd_t *rd, int len)
+{
+    uint32_t bits=rdbitu(rd,len),sign=1u<<(len-1);
+    double value=bits&(sign-1);
+    return bits&sign?-value:value;
+}
+/* skip bits by bit reader ---------------------------------------------------*/
+static void skipbits(bitrd_t *rd, int len)
+{
+    for (;len>32;len-=32) rdbitu(rd,32);
+    rdbitu(rd,len);
+}
+/* number of bits left to message end by bit reader --------------------------*/
+static int bitrd_left(const bitrd_t *rd)
+{
+    return (int)(rd->end-rd->p)*8+rd->nbit;
+}
+/* initialize bit reader -------------------------------------------------------
+* args   : bitrd_t *rd      O   bit reader
+*          uint8_t *buff    I   message data
+*          int    len       I   message length (bytes)
+*          int    pos       I   bit position from start of message (bits)
+* return : none
+* notes  : a message section is checked once by bitrd_left() before reading the
+*          fields of the section
+*-----------------------------------------------------------------------------*/
+static void init_bitrd(bitrd_t *rd, const uint8_t *buff, int len, int pos)
+{
+    rd->p=buff+(pos/8<len?pos/8:len);
+    rd->end=buff+len;
+    rd->reg=0;
+    rd->nbit=0;
+    rdbitu(rd,pos%8);
+}
+#ifdef MSM_AVX2
+static int msm_avx2=1; /* msm cell unpacking by avx2 (0:off,1:on if supported) */
+
+/* unpack fixed-width fields by avx2 -------------------------------------------
+* unpack 8 fields at a time by 32-bit gathers at the byte offsets of the fields
+* while the gathers are in the message (len<=24)
+*-----------------------------------------------------------------------------*/
+__attribute__((target("avx2")))
+static int unpack_avx2(const uint8_t *buff, int nbyte, int pos, int len,
+                       int sign, int n, int *val)
+{
+    const __m256i swap=_mm256_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12,
+                                        3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+    const __m256i step=_mm256_mullo_epi32(_mm256_setr_epi32(0,1,2,3,4,5,6,7),
+                                          _mm256_set1_epi32(len));
+    const __m128i cnt=_mm_cvtsi32_si128(32-len);
+    __m256i p,w;
+    int i;
+
+    for (i=0;i+8<=n&&(pos+(i+7)*len)/8+4<=nbyte;i+=8) {
+        p=_mm256_add_epi32(_mm256_set1_epi32(pos+i*len),step);
+        w=_mm256_i32gather_epi32((const int *)buff,_mm256_srli_epi32(p,3),1);
+        w=_mm256_shuffle_epi8(w,swap); /* big-endian */
+        w=_mm256_sllv_epi32(w,_mm256_and_si256(p,_mm256_set1_epi32(7)));
+        w=sign?_mm256_sra_epi32(w,cnt):_mm256_srl_epi32(w,cnt);
+        _mm256_storeu_si256((__m256i *)(val+i),w);
+    }
+    return i;
+}
+#endif /* MSM_AVX2 */
+/* read fixed-width fields by bit reader ---------------------------------------
+* read an array of fixed-width fields (msm satellite or cell data)
+* args   : bitrd_t *rd      IO  bit reader
+*          int    len       I   bit length of a field (bits) (len<=24)
+*          int    sign      I   signed fields (0:unsigned,1:signed)
+*          int    n         I   number of fields
+*          int    *val      O   fields {val[0],...,val[n-1]}
+* return : none
+*-----------------------------------------------------------------------------*/
+static void rdcells(bitrd_t *rd, int len, int sign, int n, int *val)
+{
+    int i=0;
+#ifdef MSM_AVX2
+    const uint8_t *buff;
+    int nb,pos;
+
+    if (msm_avx2&&n>=8&&rd->nbit>=0&&__builtin_cpu_supports("avx2")) {
+        nb=(rd->nbit+7)/8; /* bytes of bits in register */
+        buff=rd->p-nb;
+        pos=nb*8-rd->nbit;
+        if ((i=unpack_avx2(buff,(int)(rd->end-buff),pos,len,sign,n,val))>0) {
+            pos+=i*len;
+            rd->p=buff+pos/8;
+            rd->reg=0;
+            rd->nbit=0;
+            rdbitu(rd,pos%8);
+        }
+    }
+#endif
+    for (;i<n;i++) {
+        val[i]=sign?rdbits(rd,len):(int)rdbitu(rd,len);
+    }
+}
+/* time of week to time nearest to reference time ----------------------------*/
+static gtime_t tow2time(gtime_t time, double tow)
 {
     double tow_p;
     int week;
 
-    /* if no time, get cpu time */
-    if (rtcm->time.time==0) rtcm->time=utc2gpst(timeget());
-    tow_p=time2gpst(rtcm->time,&week);
+    tow_p=time2gpst(time,&week);
     if      (tow<tow_p-302400.0) tow+=604800.0;
     else if (tow>tow_p+302400.0) tow-=604800.0;
-    rtcm->time=gpst2time(week,tow);
+    return gpst2time(week,tow);
+}
+/* GLONASS time of day to time nearest to reference time ---------------------*/
+static gtime_t tod2time(gtime_t time, double tod)
+{
+    double tow,tod_p;
+    int week;
+
+    time=timeadd(gpst2utc(time),10800.0); /* glonass time */
+    tow=time2gpst(time,&week);
+    tod_p=fmod(tow,86400.0); tow-=tod_p;
+    if      (tod<tod_p-43200.0) tod+=86400.0;
+    else if (tod>tod_p+43200.0) tod-=86400.0;
+    time=gpst2time(week,tow+tod);
+    return utc2gpst(timeadd(time,-10800.0));
+}
+/* adjust weekly rollover of GPS time ----------------------------------------*/
+static void adjweek(rtcm_t *rtcm, double tow)
+{
+    /* if no time, get cpu time */
+    if (rtcm->time.time==0) rtcm->time=utc2gpst(timeget());
+    rtcm->time=tow2time(rtcm->time,tow);
 }
 /* adjust weekly rollover of BDS time ----------------------------------------*/
 static int adjbdtweek(int week)
@@ -184,18 +373,8 @@ static int adjbdtweek(int week)
 /* adjust daily rollover of GLONASS time -------------------------------------*/
 static void adjday_glot(rtcm_t *rtcm, double tod)
 {
-    gtime_t time;
-    double tow,tod_p;
-    int week;
-
     if (rtcm->time.time==0) rtcm->time=utc2gpst(timeget());
-    time=timeadd(gpst2utc(rtcm->time),10800.0); /* glonass time */
-    tow=time2gpst(time,&week);
-    tod_p=fmod(tow,86400.0); tow-=tod_p;
-    if      (tod<tod_p-43200.0) tod+=86400.0;
-    else if (tod>tod_p+43200.0) tod-=86400.0;
-    time=gpst2time(week,tow+tod);
-    rtcm->time=utc2gpst(timeadd(time,-10800.0));
+    rtcm->time=tod2time(rtcm->time,tod);
 }
 /* adjust carrier-phase rollover ---------------------------------------------*/
 static double adjcp(rtcm_t *rtcm, int sat, int idx, double cp)
@@ -254,7 +433,7 @@ static int test_staid(rtcm_t *rtcm, int staid)
         rtcm->staid=staid;
     }
     else if (staid!=rtcm->staid) {
-        type=getbitu(rtcm->buff,24,12);
+        type=getbitu(rtcm->pbuff,24,12);
         trace(2,"rtcm3 %d staid invalid id=%d %d\n",type,staid,rtcm->staid);
 
         /* reset station id if station id error */
@@ -263,25 +442,36 @@ static int test_staid(rtcm_t *rtcm, int staid)
     }
     return 1;
 }
+/* peek type 1001-1004 message header ----------------------------------------*/
+static int peek_head1001(const uint8_t *buff, int len, rtcm_head_t *head,
+                         double *tow)
+{
+    int i=24+12;
+
+    if (i+52>len*8) return -1;
+    head->staid=getbitu(buff,i,12);       i+=12;
+    *tow       =getbitu(buff,i,30)*0.001; i+=30;
+    head->sync =getbitu(buff,i, 1);       i+= 1;
+    head->nsat =getbitu(buff,i, 5);
+    return head->nsat;
+}
 /* decode type 1001-1004 message header --------------------------------------*/
 static int decode_head1001(rtcm_t *rtcm, int *sync)
 {
+    rtcm_head_t head={0};
     double tow;
     char *msg,tstr[64];
-    int i=24,staid,nsat,type;
+    int staid,nsat,type;
 
-    type=getbitu(rtcm->buff,i,12); i+=12;
+    type=getbitu(rtcm->pbuff,24,12);
 
-    if (i+52<=rtcm->len*8) {
-        staid=getbitu(rtcm->buff,i,12);       i+=12;
-        tow  =getbitu(rtcm->buff,i,30)*0.001; i+=30;
-        *sync=getbitu(rtcm->buff,i, 1);       i+= 1;
-        nsat =getbitu(rtcm->buff,i, 5);
-    }
-    else {
+    if ((nsat=peek_head1001(rtcm->pbuff,rtcm->len,&head,&tow))<0) {
         trace(2,"rtcm3 %d length error: len=%d\n",type,rtcm->len);
         return -1;
     }
+    staid=head.staid;
+    *sync=head.sync;
+
     /* test station ID */
     if (!test_staid(rtcm,staid)) return -1;
 
@@ -313,13 +503,13 @@ static int decode_type1002(rtcm_t *rtcm)
     if ((nsat=decode_head1001(rtcm,&sync))<0) return -1;
 
     for (j=0;j<nsat&&rtcm->obs.n<MAXOBS&&i+74<=rtcm->len*8;j++) {
-        prn  =getbitu(rtcm->buff,i, 6); i+= 6;
-        code =getbitu(rtcm->buff,i, 1); i+= 1;
-        pr1  =getbitu(rtcm->buff,i,24); i+=24;
-        ppr1 =getbits(rtcm->buff,i,20); i+=20;
-        lock1=getbitu(rtcm->buff,i, 7); i+= 7;
-        amb  =getbitu(rtcm->buff,i, 8); i+= 8;
-        cnr1 =getbitu(rtcm->buff,i, 8); i+= 8;
+        prn  =getbitu(rtcm->pbuff,i, 6); i+= 6;
+        code =getbitu(rtcm->pbuff,i, 1); i+= 1;
+        pr1  =getbitu(rtcm->pbuff,i,24); i+=24;
+        ppr1 =getbits(rtcm->pbuff,i,20); i+=20;
+        lock1=getbitu(rtcm->pbuff,i, 7); i+= 7;
+        amb  =getbitu(rtcm->pbuff,i, 8); i+= 8;
+        cnr1 =getbitu(rtcm->pbuff,i, 8); i+= 8;
         if (prn<40) {
             sys=SYS_GPS;
         }
@@ -367,18 +557,18 @@ static int decode_type1004(rtcm_t *rtcm)
     if ((nsat=decode_head1001(rtcm,&sync))<0) return -1;
 
     for (j=0;j<nsat&&rtcm->obs.n>0&&rtcm->obs.n<MAXOBS&&i+125<=rtcm->len*8;j++) {
-        prn  =getbitu(rtcm->buff,i, 6); i+= 6;
-        code1=getbitu(rtcm->buff,i, 1); i+= 1;
-        pr1  =getbitu(rtcm->buff,i,24); i+=24;
-        ppr1 =getbits(rtcm->buff,i,20); i+=20;
-        lock1=getbitu(rtcm->buff,i, 7); i+= 7;
-        amb  =getbitu(rtcm->buff,i, 8); i+= 8;
-        cnr1 =getbitu(rtcm->buff,i, 8); i+= 8;
-        code2=getbitu(rtcm->buff,i, 2); i+= 2;
-        pr21 =getbits(rtcm->buff,i,14); i+=14;
-        ppr2 =getbits(rtcm->buff,i,20); i+=20;
-        lock2=getbitu(rtcm->buff,i, 7); i+= 7;
-        cnr2 =getbitu(rtcm->buff,i, 8); i+= 8;
+        prn  =getbitu(rtcm->pbuff,i, 6); i+= 6;
+        code1=getbitu(rtcm->pbuff,i, 1); i+= 1;
+        pr1  =getbitu(rtcm->pbuff,i,24); i+=24;
+        ppr1 =getbits(rtcm->pbuff,i,20); i+=20;
+        lock1=getbitu(rtcm->pbuff,i, 7); i+= 7;
+        amb  =getbitu(rtcm->pbuff,i, 8); i+= 8;
+        cnr1 =getbitu(rtcm->pbuff,i, 8); i+= 8;
+        code2=getbitu(rtcm->pbuff,i, 2); i+= 2;
+        pr21 =getbits(rtcm->pbuff,i,14); i+=14;
+        ppr2 =getbits(rtcm->pbuff,i,20); i+=20;
+        lock2=getbitu(rtcm->pbuff,i, 7); i+= 7;
+        cnr2 =getbitu(rtcm->pbuff,i, 8); i+= 8;
         if (prn<40) {
             sys=SYS_GPS;
         }
@@ -431,17 +621,11 @@ static int decode_type1005(rtcm_t *rtcm)
     char *msg;
     int i=24+12,j,staid,itrf;
 
-    if (i+140==rtcm->len*8) {
-        staid=getbitu(rtcm->buff,i,12); i+=12;
-        itrf =getbitu(rtcm->buff,i, 6); i+= 6+4;
-        rr[0]=getbits_38(rtcm->buff,i); i+=38+2;
-        rr[1]=getbits_38(rtcm->buff,i); i+=38+2;
-        rr[2]=getbits_38(rtcm->buff,i);
-    }
-    else {
-        trace(2,"rtcm3 1005 length error: len=%d\n",rtcm->len);
-        return -1;
-    }
+    staid=getbitu(rtcm->pbuff,i,12); i+=12;
+    itrf =getbitu(rtcm->pbuff,i, 6); i+= 6+4;
+    rr[0]=getbits_38(rtcm->pbuff,i); i+=38+2;
+    rr[1]=getbits_38(rtcm->pbuff,i); i+=38+2;
+    rr[2]=getbits_38(rtcm->pbuff,i);
     if (rtcm->outtype) {
         msg=rtcm->msgtype+strlen(rtcm->msgtype);
         for (j=0;j<3;j++) re[j]=rr[j]*0.0001;
@@ -469,18 +653,12 @@ static int decode_type1006(rtcm_t *rtcm)
     char *msg;
     int i=24+12,j,staid,itrf;
 
-    if (i+156<=rtcm->len*8) {
-        staid=getbitu(rtcm->buff,i,12); i+=12;
-        itrf =getbitu(rtcm->buff,i, 6); i+= 6+4;
-        rr[0]=getbits_38(rtcm->buff,i); i+=38+2;
-        rr[1]=getbits_38(rtcm->buff,i); i+=38+2;
-        rr[2]=getbits_38(rtcm->buff,i); i+=38;
-        anth =getbitu(rtcm->buff,i,16);
-    }
-    else {
-        trace(2,"rtcm3 1006 length error: len=%d\n",rtcm->len);
-        return -1;
-    }
+    staid=getbitu(rtcm->pbuff,i,12); i+=12;
+    itrf =getbitu(rtcm->pbuff,i, 6); i+= 6+4;
+    rr[0]=getbits_38(rtcm->pbuff,i); i+=38+2;
+    rr[1]=getbits_38(rtcm->pbuff,i); i+=38+2;
+    rr[2]=getbits_38(rtcm->pbuff,i); i+=38;
+    anth =getbitu(rtcm->pbuff,i,16);
     if (rtcm->outtype) {
         msg=rtcm->msgtype+strlen(rtcm->msgtype);
         for (j=0;j<3;j++) re[j]=rr[j]*0.0001;
@@ -508,14 +686,14 @@ static int decode_type1007(rtcm_t *rtcm)
     char *msg;
     int i=24+12,j,staid,n,setup;
 
-    n=getbitu(rtcm->buff,i+12,8);
+    n=getbitu(rtcm->pbuff,i+12,8);
 
     if (i+28+8*n<=rtcm->len*8) {
-        staid=getbitu(rtcm->buff,i,12); i+=12+8;
+        staid=getbitu(rtcm->pbuff,i,12); i+=12+8;
         for (j=0;j<n&&j<31;j++) {
-            des[j]=(char)getbitu(rtcm->buff,i,8); i+=8;
+            des[j]=(char)getbitu(rtcm->pbuff,i,8); i+=8;
         }
-        setup=getbitu(rtcm->buff,i, 8);
+        setup=getbitu(rtcm->pbuff,i, 8);
     }
     else {
         trace(2,"rtcm3 1007 length error: len=%d\n",rtcm->len);
@@ -529,7 +707,7 @@ static int decode_type1007(rtcm_t *rtcm)
     if (!test_staid(rtcm,staid)) return -1;
 
     sprintf(rtcm->sta.name,"%04d",staid);
-    strncpy(rtcm->sta.antdes,des,n); rtcm->sta.antdes[n]='\0';
+    strcpy(rtcm->sta.antdes,des); /* des: up to 31 chars */
     rtcm->sta.antsetup=setup;
     rtcm->sta.antsno[0]='\0';
     return 5;
@@ -541,17 +719,18 @@ static int decode_type1008(rtcm_t *rtcm)
     char *msg;
     int i=24+12,j,staid,n,m,setup;
 
-    n=getbitu(rtcm->buff,i+12,8);
-    m=getbitu(rtcm->buff,i+28+8*n,8);
+    /* length bytes are read only within message */
+    n=getbitu(rtcm->pbuff,i+12,8);
+    m=i+36+8*n<=rtcm->len*8?getbitu(rtcm->pbuff,i+28+8*n,8):0;
 
     if (i+36+8*(n+m)<=rtcm->len*8) {
-        staid=getbitu(rtcm->buff,i,12); i+=12+8;
+        staid=getbitu(rtcm->pbuff,i,12); i+=12+8;
         for (j=0;j<n&&j<31;j++) {
-            des[j]=(char)getbitu(rtcm->buff,i,8); i+=8;
+            des[j]=(char)getbitu(rtcm->pbuff,i,8); i+=8;
         }
-        setup=getbitu(rtcm->buff,i, 8); i+=8+8;
+        setup=getbitu(rtcm->pbuff,i, 8); i+=8+8;
         for (j=0;j<m&&j<31;j++) {
-            sno[j]=(char)getbitu(rtcm->buff,i,8); i+=8;
+            sno[j]=(char)getbitu(rtcm->pbuff,i,8); i+=8;
         }
     }
     else {
@@ -566,30 +745,41 @@ static int decode_type1008(rtcm_t *rtcm)
     if (!test_staid(rtcm,staid)) return -1;
 
     sprintf(rtcm->sta.name,"%04d",staid);
-    strncpy(rtcm->sta.antdes,des,n); rtcm->sta.antdes[n]='\0';
+    strcpy(rtcm->sta.antdes,des); /* des,sno: up to 31 chars */
     rtcm->sta.antsetup=setup;
-    strncpy(rtcm->sta.antsno,sno,m); rtcm->sta.antsno[m]='\0';
+    strcpy(rtcm->sta.antsno,sno);
     return 5;
 }
+/* peek type 1009-1012 message header ----------------------------------------*/
+static int peek_head1009(const uint8_t *buff, int len, rtcm_head_t *head,
+                         double *tod)
+{
+    int i=24+12;
+
+    if (i+49>len*8) return -1;
+    head->staid=getbitu(buff,i,12);       i+=12;
+    *tod       =getbitu(buff,i,27)*0.001; i+=27; /* sec in a day */
+    head->sync =getbitu(buff,i, 1);       i+= 1;
+    head->nsat =getbitu(buff,i, 5);
+    return head->nsat;
+}
 /* decode type 1009-1012 message header --------------------------------------*/
 static int decode_head1009(rtcm_t *rtcm, int *sync)
 {
+    rtcm_head_t head={0};
     double tod;
     char *msg,tstr[64];
-    int i=24,staid,nsat,type;
+    int staid,nsat,type;
 
-    type=getbitu(rtcm->buff,i,12); i+=12;
+    type=getbitu(rtcm->pbuff,24,12);
 
-    if (i+49<=rtcm->len*8) {
-        staid=getbitu(rtcm->buff,i,12);       i+=12;
-        tod  =getbitu(rtcm->buff,i,27)*0.001; i+=27; /* sec in a day */
-        *sync=getbitu(rtcm->buff,i, 1);       i+= 1;
-        nsat =getbitu(rtcm->buff,i, 5);
-    }
-    else {
+    if ((nsat=peek_head1009(rtcm->pbuff,rtcm->len,&head,&tod))<0) {
         trace(2,"rtcm3 %d length error: len=%d\n",type,rtcm->len);
         return -1;
     }
+    staid=head.staid;
+    *sync=head.sync;
+
     /* test station ID */
     if (!test_staid(rtcm,staid)) return -1;
 
@@ -621,14 +811,14 @@ static int decode_type1010(rtcm_t *rtcm)
     if ((nsat=decode_head1009(rtcm,&sync))<0) return -1;
 
     for (j=0;j<nsat&&rtcm->obs.n<MAXOBS&&i+79<=rtcm->len*8;j++) {
-        prn  =getbitu(rtcm->buff,i, 6); i+= 6;
-        code =getbitu(rtcm->buff,i, 1); i+= 1;
-        fcn  =getbitu(rtcm->buff,i, 5); i+= 5; /* fcn+7 */
-        pr1  =getbitu(rtcm->buff,i,25); i+=25;
-        ppr1 =getbits(rtcm->buff,i,20); i+=20;
-        lock1=getbitu(rtcm->buff,i, 7); i+= 7;
-        amb  =getbitu(rtcm->buff,i, 7); i+= 7;
-        cnr1 =getbitu(rtcm->buff,i, 8); i+= 8;
+        prn  =getbitu(rtcm->pbuff,i, 6); i+= 6;
+        code =getbitu(rtcm->pbuff,i, 1); i+= 1;
+        fcn  =getbitu(rtcm->pbuff,i, 5); i+= 5; /* fcn+7 */
+        pr1  =getbitu(rtcm->pbuff,i,25); i+=25;
+        ppr1 =getbits(rtcm->pbuff,i,20); i+=20;
+        lock1=getbitu(rtcm->pbuff,i, 7); i+= 7;
+        amb  =getbitu(rtcm->pbuff,i, 7); i+= 7;
+        cnr1 =getbitu(rtcm->pbuff,i, 8); i+= 8;
         if (!(sat=satno(sys,prn))) {
             trace(2,"rtcm3 1010 satellite number error: prn=%d\n",prn);
             continue;
@@ -673,19 +863,19 @@ static int decode_type1012(rtcm_t *rtcm)
     if ((nsat=decode_head1009(rtcm,&sync))<0) return -1;
 
     for (j=0;j<nsat&&rtcm->obs.n<MAXOBS&&i+130<=rtcm->len*8;j++) {
-        prn  =getbitu(rtcm->buff,i, 6); i+= 6;
-        code1=getbitu(rtcm->buff,i, 1); i+= 1;
-        fcn  =getbitu(rtcm->buff,i, 5); i+= 5; /* fcn+7 */
-        pr1  =getbitu(rtcm->buff,i,25); i+=25;
-        ppr1 =getbits(rtcm->buff,i,20); i+=20;
-        lock1=getbitu(rtcm->buff,i, 7); i+= 7;
-        amb  =getbitu(rtcm->buff,i, 7); i+= 7;
-        cnr1 =getbitu(rtcm->buff,i, 8); i+= 8;
-        code2=getbitu(rtcm->buff,i, 2); i+= 2;
-        pr21 =getbits(rtcm->buff,i,14); i+=14;
-        ppr2 =getbits(rtcm->buff,i,20); i+=20;
-        lock2=getbitu(rtcm->buff,i, 7); i+= 7;
-        cnr2 =getbitu(rtcm->buff,i, 8); i+= 8;
+        prn  =getbitu(rtcm->pbuff,i, 6); i+= 6;
+        code1=getbitu(rtcm->pbuff,i, 1); i+= 1;
+        fcn  =getbitu(rtcm->pbuff,i, 5); i+= 5; /* fcn+7 */
+        pr1  =getbitu(rtcm->pbuff,i,25); i+=25;
+        ppr1 =getbits(rtcm->pbuff,i,20); i+=20;
+        lock1=getbitu(rtcm->pbuff,i, 7); i+= 7;
+        amb  =getbitu(rtcm->pbuff,i, 7); i+= 7;
+        cnr1 =getbitu(rtcm->pbuff,i, 8); i+= 8;
+        code2=getbitu(rtcm->pbuff,i, 2); i+= 2;
+        pr21 =getbits(rtcm->pbuff,i,14); i+=14;
+        ppr2 =getbits(rtcm->pbuff,i,20); i+=20;
+        lock2=getbitu(rtcm->pbuff,i, 7); i+= 7;
+        cnr2 =getbitu(rtcm->pbuff,i, 8); i+= 8;
         if (!(sat=satno(sys,prn))) {
             trace(2,"rtcm3 1012 satellite number error: sys=%d prn=%d\n",sys,prn);
             continue;
@@ -730,50 +920,253 @@ static int decode_type1013(rtcm_t *rtcm)
 {
     return 0;
 }
+/* ephemeris message field schemas ---------------------------------------------
+* fields FLD(kind,bits,destination,scale) following message number in order
+*     kind: U=unsigned, F=unsigned scaled, S=signed scaled,
+*           G=sign-magnitude scaled, X=not decoded
+* a schema is expanded by RD_FIELD to the straight-line reads by bit reader rd
+* in the decoder of the message (destination: lvalue in the decoder)
+*-----------------------------------------------------------------------------*/
+#define RD_FIELD(kind,bits,dst,scale) RD_##kind(bits,dst,scale)
+#define RD_U(bits,dst,scale) dst=rdbitu(&rd,bits);
+#define RD_F(bits,dst,scale) dst=rdbitu(&rd,bits)*scale;
+#define RD_S(bits,dst,scale) dst=rdbits(&rd,bits)*scale;
+#define RD_G(bits,dst,scale) dst=rdbitg(&rd,bits)*scale;
+#define RD_X(bits,dst,scale) skipbits(&rd,bits);
+
+#define MT1019(FLD) /* GPS ephemerides */ \
+    FLD(U, 6,prn       ,1           ) \
+    FLD(U,10,week      ,1           ) \
+    FLD(U, 4,eph.sva   ,1           ) \
+    FLD(U, 2,eph.code  ,1           ) \
+    FLD(S,14,eph.idot  ,P2_43*SC2RAD) \
+    FLD(U, 8,eph.iode  ,1           ) \
+    FLD(F,16,toc       ,16.0        ) \
+    FLD(S, 8,eph.f2    ,P2_55       ) \
+    FLD(S,16,eph.f1    ,P2_43       ) \
+    FLD(S,22,eph.f0    ,P2_31       ) \
+    FLD(U,10,eph.iodc  ,1           ) \
+    FLD(S,16,eph.crs   ,P2_5        ) \
+    FLD(S,16,eph.deln  ,P2_43*SC2RAD) \
+    FLD(S,32,eph.M0    ,P2_31*SC2RAD) \
+    FLD(S,16,eph.cuc   ,P2_29       ) \
+    FLD(F,32,eph.e     ,P2_33       ) \
+    FLD(S,16,eph.cus   ,P2_29       ) \
+    FLD(F,32,sqrtA     ,P2_19       ) \
+    FLD(F,16,eph.toes  ,16.0        ) \
+    FLD(S,16,eph.cic   ,P2_29       ) \
+    FLD(S,32,eph.OMG0  ,P2_31*SC2RAD) \
+    FLD(S,16,eph.cis   ,P2_29       ) \
+    FLD(S,32,eph.i0    ,P2_31*SC2RAD) \
+    FLD(S,16,eph.crc   ,P2_5        ) \
+    FLD(S,32,eph.omg   ,P2_31*SC2RAD) \
+    FLD(S,24,eph.OMGd  ,P2_43*SC2RAD) \
+    FLD(S, 8,eph.tgd[0],P2_31       ) \
+    FLD(U, 6,eph.svh   ,1           ) \
+    FLD(U, 1,eph.flag  ,1           ) \
+    FLD(U, 1,fit       ,1           )
+
+#define MT1020(FLD) /* GLONASS ephemerides */ \
+    FLD(U, 6,prn        ,1        ) \
+    FLD(U, 5,geph.frq   ,1        ) \
+    FLD(X, 2,0          ,1        ) \
+    FLD(X, 2,0          ,1        ) \
+    FLD(U, 5,tk_h       ,1        ) \
+    FLD(U, 6,tk_m       ,1        ) \
+    FLD(F, 1,tk_s       ,30.0     ) \
+    FLD(U, 1,bn         ,1        ) \
+    FLD(X, 1,0          ,1        ) \
+    FLD(U, 7,tb         ,1        ) \
+    FLD(G,24,geph.vel[0],P2_20*1E3) \
+    FLD(G,27,geph.pos[0],P2_11*1E3) \
+    FLD(G, 5,geph.acc[0],P2_30*1E3) \
+    FLD(G,24,geph.vel[1],P2_20*1E3) \
+    FLD(G,27,geph.pos[1],P2_11*1E3) \
+    FLD(G, 5,geph.acc[1],P2_30*1E3) \
+    FLD(G,24,geph.vel[2],P2_20*1E3) \
+    FLD(G,27,geph.pos[2],P2_11*1E3) \
+    FLD(G, 5,geph.acc[2],P2_30*1E3) \
+    FLD(X, 1,0          ,1        ) \
+    FLD(G,11,geph.gamn  ,P2_40    ) \
+    FLD(X, 3,0          ,1        ) \
+    FLD(G,22,geph.taun  ,P2_30    ) \
+    FLD(G, 5,geph.dtaun ,P2_30    ) \
+    FLD(U, 5,geph.age   ,1        )
+
+#define MT1041(FLD) /* NavIC/IRNSS ephemerides */ \
+    FLD(U, 6,prn       ,1           )                \
+    FLD(U,10,week      ,1           )                \
+    FLD(S,22,eph.f0    ,P2_31       )                \
+    FLD(S,16,eph.f1    ,P2_43       )                \
+    FLD(S, 8,eph.f2    ,P2_55       )                \
+    FLD(U, 4,eph.sva   ,1           )                \
+    FLD(F,16,toc       ,16.0        )                \
+    FLD(S, 8,eph.tgd[0],P2_31       )                \
+    FLD(S,22,eph.deln  ,P2_41*SC2RAD)                \
+    FLD(U, 8,eph.iode  ,1           )                \
+    FLD(X,10,0         ,1           ) /* IODEC */    \
+    FLD(U, 2,eph.svh   ,1           ) /* L5+Sflag */ \
+    FLD(S,15,eph.cuc   ,P2_28       )                \
+    FLD(S,15,eph.cus   ,P2_28       )                \
+    FLD(S,15,eph.cic   ,P2_28       )                \
+    FLD(S,15,eph.cis   ,P2_28       )                \
+    FLD(S,15,eph.crc   ,0.0625      )                \
+    FLD(S,15,eph.crs   ,0.0625      )                \
+    FLD(S,14,eph.idot  ,P2_43*SC2RAD)                \
+    FLD(S,32,eph.M0    ,P2_31*SC2RAD)                \
+    FLD(F,16,eph.toes  ,16.0        )                \
+    FLD(F,32,eph.e     ,P2_33       )                \
+    FLD(F,32,sqrtA     ,P2_19       )                \
+    FLD(S,32,eph.OMG0  ,P2_31*SC2RAD)                \
+    FLD(S,32,eph.omg   ,P2_31*SC2RAD)                \
+    FLD(S,22,eph.OMGd  ,P2_41*SC2RAD)                \
+    FLD(S,32,eph.i0    ,P2_31*SC2RAD)
+
+#define MT1042(FLD) /* Beidou ephemerides */ \
+    FLD(U, 6,prn       ,1           )            \
+    FLD(U,13,week      ,1           )            \
+    FLD(U, 4,eph.sva   ,1           )            \
+    FLD(S,14,eph.idot  ,P2_43*SC2RAD)            \
+    FLD(U, 5,eph.iode  ,1           ) /* AODE */ \
+    FLD(F,17,toc       ,8.0         )            \
+    FLD(S,11,eph.f2    ,P2_66       )            \
+    FLD(S,22,eph.f1    ,P2_50       )            \
+    FLD(S,24,eph.f0    ,P2_33       )            \
+    FLD(U, 5,eph.iodc  ,1           ) /* AODC */ \
+    FLD(S,18,eph.crs   ,P2_6        )            \
+    FLD(S,16,eph.deln  ,P2_43*SC2RAD)            \
+    FLD(S,32,eph.M0    ,P2_31*SC2RAD)            \
+    FLD(S,18,eph.cuc   ,P2_31       )            \
+    FLD(F,32,eph.e     ,P2_33       )            \
+    FLD(S,18,eph.cus   ,P2_31       )            \
+    FLD(F,32,sqrtA     ,P2_19       )            \
+    FLD(F,17,eph.toes  ,8.0         )            \
+    FLD(S,18,eph.cic   ,P2_31       )            \
+    FLD(S,32,eph.OMG0  ,P2_31*SC2RAD)            \
+    FLD(S,18,eph.cis   ,P2_31       )            \
+    FLD(S,32,eph.i0    ,P2_31*SC2RAD)            \
+    FLD(S,18,eph.crc   ,P2_6        )            \
+    FLD(S,32,eph.omg   ,P2_31*SC2RAD)            \
+    FLD(S,24,eph.OMGd  ,P2_43*SC2RAD)            \
+    FLD(S,10,eph.tgd[0],1E-10       )            \
+    FLD(S,10,eph.tgd[1],1E-10       )            \
+    FLD(U, 1,eph.svh   ,1           )
+
+#define MT1044(FLD) /* QZSS ephemerides */ \
+    FLD(U, 4,prn       ,1           ) \
+    FLD(F,16,toc       ,16.0        ) \
+    FLD(S, 8,eph.f2    ,P2_55       ) \
+    FLD(S,16,eph.f1    ,P2_43       ) \
+    FLD(S,22,eph.f0    ,P2_31       ) \
+    FLD(U, 8,eph.iode  ,1           ) \
+    FLD(S,16,eph.crs   ,P2_5        ) \
+    FLD(S,16,eph.deln  ,P2_43*SC2RAD) \
+    FLD(S,32,eph.M0    ,P2_31*SC2RAD) \
+    FLD(S,16,eph.cuc   ,P2_29       ) \
+    FLD(F,32,eph.e     ,P2_33       ) \
+    FLD(S,16,eph.cus   ,P2_29       ) \
+    FLD(F,32,sqrtA     ,P2_19       ) \
+    FLD(F,16,eph.toes  ,16.0        ) \
+    FLD(S,16,eph.cic   ,P2_29       ) \
+    FLD(S,32,eph.OMG0  ,P2_31*SC2RAD) \
+    FLD(S,16,eph.cis   ,P2_29       ) \
+    FLD(S,32,eph.i0    ,P2_31*SC2RAD) \
+    FLD(S,16,eph.crc   ,P2_5        ) \
+    FLD(S,32,eph.omg   ,P2_31*SC2RAD) \
+    FLD(S,24,eph.OMGd  ,P2_43*SC2RAD) \
+    FLD(S,14,eph.idot  ,P2_43*SC2RAD) \
+    FLD(U, 2,eph.code  ,1           ) \
+    FLD(U,10,week      ,1           ) \
+    FLD(U, 4,eph.sva   ,1           ) \
+    FLD(U, 6,eph.svh   ,1           ) \
+    FLD(S, 8,eph.tgd[0],P2_31       ) \
+    FLD(U,10,eph.iodc  ,1           ) \
+    FLD(U, 1,fit       ,1           )
+
+#define MT1045(FLD) /* Galileo F/NAV satellite ephemerides */ \
+    FLD(U, 6,prn       ,1           )                \
+    FLD(U,12,week      ,1           ) /* gst-week */ \
+    FLD(U,10,eph.iode  ,1           )                \
+    FLD(U, 8,eph.sva   ,1           )                \
+    FLD(S,14,eph.idot  ,P2_43*SC2RAD)                \
+    FLD(F,14,toc       ,60.0        )                \
+    FLD(S, 6,eph.f2    ,P2_59       )                \
+    FLD(S,21,eph.f1    ,P2_46       )                \
+    FLD(S,31,eph.f0    ,P2_34       )                \
+    FLD(S,16,eph.crs   ,P2_5        )                \
+    FLD(S,16,eph.deln  ,P2_43*SC2RAD)                \
+    FLD(S,32,eph.M0    ,P2_31*SC2RAD)                \
+    FLD(S,16,eph.cuc   ,P2_29       )                \
+    FLD(F,32,eph.e     ,P2_33       )                \
+    FLD(S,16,eph.cus   ,P2_29       )                \
+    FLD(F,32,sqrtA     ,P2_19       )                \
+    FLD(F,14,eph.toes  ,60.0        )                \
+    FLD(S,16,eph.cic   ,P2_29       )                \
+    FLD(S,32,eph.OMG0  ,P2_31*SC2RAD)                \
+    FLD(S,16,eph.cis   ,P2_29       )                \
+    FLD(S,32,eph.i0    ,P2_31*SC2RAD)                \
+    FLD(S,16,eph.crc   ,P2_5        )                \
+    FLD(S,32,eph.omg   ,P2_31*SC2RAD)                \
+    FLD(S,24,eph.OMGd  ,P2_43*SC2RAD)                \
+    FLD(S,10,eph.tgd[0],P2_32       ) /* E5a/E1 */   \
+    FLD(U, 2,e5a_hs    ,1           ) /* OSHS */     \
+    FLD(U, 1,e5a_dvs   ,1           ) /* OSDVS */    \
+    FLD(X, 7,0         ,1           )
+
+#define MT1046(FLD) /* Galileo I/NAV satellite ephemerides */ \
+    FLD(U, 6,prn       ,1           )                 \
+    FLD(U,12,week      ,1           )                 \
+    FLD(U,10,eph.iode  ,1           )                 \
+    FLD(U, 8,eph.sva   ,1           )                 \
+    FLD(S,14,eph.idot  ,P2_43*SC2RAD)                 \
+    FLD(F,14,toc       ,60.0        )                 \
+    FLD(S, 6,eph.f2    ,P2_59       )                 \
+    FLD(S,21,eph.f1    ,P2_46       )                 \
+    FLD(S,31,eph.f0    ,P2_34       )                 \
+    FLD(S,16,eph.crs   ,P2_5        )                 \
+    FLD(S,16,eph.deln  ,P2_43*SC2RAD)                 \
+    FLD(S,32,eph.M0    ,P2_31*SC2RAD)                 \
+    FLD(S,16,eph.cuc   ,P2_29       )                 \
+    FLD(F,32,eph.e     ,P2_33       )                 \
+    FLD(S,16,eph.cus   ,P2_29       )                 \
+    FLD(F,32,sqrtA     ,P2_19       )                 \
+    FLD(F,14,eph.toes  ,60.0        )                 \
+    FLD(S,16,eph.cic   ,P2_29       )                 \
+    FLD(S,32,eph.OMG0  ,P2_31*SC2RAD)                 \
+    FLD(S,16,eph.cis   ,P2_29       )                 \
+    FLD(S,32,eph.i0    ,P2_31*SC2RAD)                 \
+    FLD(S,16,eph.crc   ,P2_5        )                 \
+    FLD(S,32,eph.omg   ,P2_31*SC2RAD)                 \
+    FLD(S,24,eph.OMGd  ,P2_43*SC2RAD)                 \
+    FLD(S,10,eph.tgd[0],P2_32       ) /* E5a/E1 */    \
+    FLD(S,10,eph.tgd[1],P2_32       ) /* E5b/E1 */    \
+    FLD(U, 2,e5b_hs    ,1           ) /* E5b OSHS */  \
+    FLD(U, 1,e5b_dvs   ,1           ) /* E5b OSDVS */ \
+    FLD(U, 2,e1_hs     ,1           ) /* E1 OSHS */   \
+    FLD(U, 1,e1_dvs    ,1           ) /* E1 OSDVS */
+
+/* schema length check (the fields within the fixed message length) ----------*/
+#define FIELD_BITS(kind,bits,dst,scale) +bits
+typedef char chk_mt1019[12 MT1019(FIELD_BITS)<=61*8?1:-1];
+typedef char chk_mt1020[12 MT1020(FIELD_BITS)<=45*8?1:-1];
+typedef char chk_mt1041[12 MT1041(FIELD_BITS)<=61*8?1:-1];
+typedef char chk_mt1042[12 MT1042(FIELD_BITS)<=64*8?1:-1];
+typedef char chk_mt1044[12 MT1044(FIELD_BITS)<=61*8?1:-1];
+typedef char chk_mt1045[12 MT1045(FIELD_BITS)<=62*8?1:-1];
+typedef char chk_mt1046[12 MT1046(FIELD_BITS)<=63*8?1:-1];
+
 /* decode type 1019: GPS ephemerides -----------------------------------------*/
 static int decode_type1019(rtcm_t *rtcm)
 {
+    bitrd_t rd;
     eph_t eph={0};
     double toc,sqrtA,tt;
     char *msg;
-    int i=24+12,prn,sat,week,sys=SYS_GPS;
-
-    if (i+476<=rtcm->len*8) {
-        prn       =getbitu(rtcm->buff,i, 6);              i+= 6;
-        week      =getbitu(rtcm->buff,i,10);              i+=10;
-        eph.sva   =getbitu(rtcm->buff,i, 4);              i+= 4;
-        eph.code  =getbitu(rtcm->buff,i, 2);              i+= 2;
-        eph.idot  =getbits(rtcm->buff,i,14)*P2_43*SC2RAD; i+=14;
-        eph.iode  =getbitu(rtcm->buff,i, 8);              i+= 8;
-        toc       =getbitu(rtcm->buff,i,16)*16.0;         i+=16;
-        eph.f2    =getbits(rtcm->buff,i, 8)*P2_55;        i+= 8;
-        eph.f1    =getbits(rtcm->buff,i,16)*P2_43;        i+=16;
-        eph.f0    =getbits(rtcm->buff,i,22)*P2_31;        i+=22;
-        eph.iodc  =getbitu(rtcm->buff,i,10);              i+=10;
-        eph.crs   =getbits(rtcm->buff,i,16)*P2_5;         i+=16;
-        eph.deln  =getbits(rtcm->buff,i,16)*P2_43*SC2RAD; i+=16;
-        eph.M0    =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.cuc   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        eph.e     =getbitu(rtcm->buff,i,32)*P2_33;        i+=32;
-        eph.cus   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        sqrtA     =getbitu(rtcm->buff,i,32)*P2_19;        i+=32;
-        eph.toes  =getbitu(rtcm->buff,i,16)*16.0;         i+=16;
-        eph.cic   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        eph.OMG0  =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.cis   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        eph.i0    =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.crc   =getbits(rtcm->buff,i,16)*P2_5;         i+=16;
-        eph.omg   =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.OMGd  =getbits(rtcm->buff,i,24)*P2_43*SC2RAD; i+=24;
-        eph.tgd[0]=getbits(rtcm->buff,i, 8)*P2_31;        i+= 8;
-        eph.svh   =getbitu(rtcm->buff,i, 6);              i+= 6;
-        eph.flag  =getbitu(rtcm->buff,i, 1);              i+= 1;
-        eph.fit   =getbitu(rtcm->buff,i, 1)?0.0:4.0; /* 0:4hr,1:>4hr */
-    }
-    else {
-        trace(2,"rtcm3 1019 length error: len=%d\n",rtcm->len);
-        return -1;
-    }
+    int prn,sat,week,fit,sys=SYS_GPS;
+
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
+    MT1019(RD_FIELD)
+    eph.fit=fit?0.0:4.0; /* 0:4hr,1:>4hr */
     if (prn>=40) {
         sys=SYS_SBS; prn+=80;
     }
@@ -809,37 +1202,15 @@ static int decode_type1019(rtcm_t *rtcm)
 /* decode type 1020: GLONASS ephemerides -------------------------------------*/
 static int decode_type1020(rtcm_t *rtcm)
 {
+    bitrd_t rd;
     geph_t geph={0};
     double tk_h,tk_m,tk_s,toe,tow,tod,tof;
     char *msg;
-    int i=24+12,prn,sat,week,tb,bn,sys=SYS_GLO;
-
-    if (i+348<=rtcm->len*8) {
-        prn        =getbitu(rtcm->buff,i, 6);           i+= 6;
-        geph.frq   =getbitu(rtcm->buff,i, 5)-7;         i+= 5+2+2;
-        tk_h       =getbitu(rtcm->buff,i, 5);           i+= 5;
-        tk_m       =getbitu(rtcm->buff,i, 6);           i+= 6;
-        tk_s       =getbitu(rtcm->buff,i, 1)*30.0;      i+= 1;
-        bn         =getbitu(rtcm->buff,i, 1);           i+= 1+1;
-        tb         =getbitu(rtcm->buff,i, 7);           i+= 7;
-        geph.vel[0]=getbitg(rtcm->buff,i,24)*P2_20*1E3; i+=24;
-        geph.pos[0]=getbitg(rtcm->buff,i,27)*P2_11*1E3; i+=27;
-        geph.acc[0]=getbitg(rtcm->buff,i, 5)*P2_30*1E3; i+= 5;
-        geph.vel[1]=getbitg(rtcm->buff,i,24)*P2_20*1E3; i+=24;
-        geph.pos[1]=getbitg(rtcm->buff,i,27)*P2_11*1E3; i+=27;
-        geph.acc[1]=getbitg(rtcm->buff,i, 5)*P2_30*1E3; i+= 5;
-        geph.vel[2]=getbitg(rtcm->buff,i,24)*P2_20*1E3; i+=24;
-        geph.pos[2]=getbitg(rtcm->buff,i,27)*P2_11*1E3; i+=27;
-        geph.acc[2]=getbitg(rtcm->buff,i, 5)*P2_30*1E3; i+= 5+1;
-        geph.gamn  =getbitg(rtcm->buff,i,11)*P2_40;     i+=11+3;
-        geph.taun  =getbitg(rtcm->buff,i,22)*P2_30;     i+=22;
-        geph.dtaun =getbitg(rtcm->buff,i, 5)*P2_30;     i+=5;
-        geph.age   =getbitu(rtcm->buff,i, 5);
-    }
-    else {
-        trace(2,"rtcm3 1020 length error: len=%d\n",rtcm->len);
-        return -1;
-    }
+    int prn,sat,week,tb,bn,sys=SYS_GLO;
+
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
+    MT1020(RD_FIELD)
+    geph.frq-=7;
     if (!(sat=satno(sys,prn))) {
         trace(2,"rtcm3 1020 satellite number error: prn=%d\n",prn);
         return -1;
@@ -920,26 +1291,28 @@ static int decode_type1027(rtcm_t *rtcm)
 /* decode type 1029: UNICODE text string -------------------------------------*/
 static int decode_type1029(rtcm_t *rtcm)
 {
+    bitrd_t rd;
     char *msg;
-    int i=24+12,j,staid,mjd,tod,nchar,cunit;
+    int j,staid,mjd,tod,nchar,cunit;
 
-    if (i+60<=rtcm->len*8) {
-        staid=getbitu(rtcm->buff,i,12); i+=12;
-        mjd  =getbitu(rtcm->buff,i,16); i+=16;
-        tod  =getbitu(rtcm->buff,i,17); i+=17;
-        nchar=getbitu(rtcm->buff,i, 7); i+= 7;
-        cunit=getbitu(rtcm->buff,i, 8); i+= 8;
-    }
-    else {
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
+
+    if (bitrd_left(&rd)<60) {
         trace(2,"rtcm3 1029 length error: len=%d\n",rtcm->len);
         return -1;
     }
-    if (i+nchar*8>rtcm->len*8) {
+    staid=rdbitu(&rd,12);
+    mjd  =rdbitu(&rd,16);
+    tod  =rdbitu(&rd,17);
+    nchar=rdbitu(&rd, 7);
+    cunit=rdbitu(&rd, 8);
+
+    if (bitrd_left(&rd)<nchar*8) {
         trace(2,"rtcm3 1029 length error: len=%d nchar=%d\n",rtcm->len,nchar);
         return -1;
     }
     for (j=0;j<nchar&&j<126;j++) {
-        rtcm->msg[j]=getbitu(rtcm->buff,i,8); i+=8;
+        rtcm->msg[j]=(char)rdbitu(&rd,8);
     }
     rtcm->msg[j]='\0';
 
@@ -970,39 +1343,26 @@ static int decode_type1032(rtcm_t *rtcm)
 /* decode type 1033: receiver and antenna descriptor -------------------------*/
 static int decode_type1033(rtcm_t *rtcm)
 {
+    bitrd_t rd;
     char des[32]="",sno[32]="",rec[32]="",ver[32]="",rsn[32]="";
-    char *msg;
-    int i=24+12,j,staid,n,m,n1,n2,n3,setup;
-
-    n =getbitu(rtcm->buff,i+12,8);
-    m =getbitu(rtcm->buff,i+28+8*n,8);
-    n1=getbitu(rtcm->buff,i+36+8*(n+m),8);
-    n2=getbitu(rtcm->buff,i+44+8*(n+m+n1),8);
-    n3=getbitu(rtcm->buff,i+52+8*(n+m+n1+n2),8);
-
-    if (i+60+8*(n+m+n1+n2+n3)<=rtcm->len*8) {
-        staid=getbitu(rtcm->buff,i,12); i+=12+8;
-        for (j=0;j<n&&j<31;j++) {
-            des[j]=(char)getbitu(rtcm->buff,i,8); i+=8;
-        }
-        setup=getbitu(rtcm->buff,i, 8); i+=8+8;
-        for (j=0;j<m&&j<31;j++) {
-            sno[j]=(char)getbitu(rtcm->buff,i,8); i+=8;
-        }
-        i+=8;
-        for (j=0;j<n1&&j<31;j++) {
-            rec[j]=(char)getbitu(rtcm->buff,i,8); i+=8;
-        }
-        i+=8;
-        for (j=0;j<n2&&j<31;j++) {
-            ver[j]=(char)getbitu(rtcm->buff,i,8); i+=8;
-        }
-        i+=8;
-        for (j=0;j<n3&&j<31;j++) {
-            rsn[j]=(char)getbitu(rtcm->buff,i,8); i+=8;
+    char *str[]={des,sno,rec,ver,rsn},*msg,c;
+    int i,j,n,staid,setup=0;
+
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
+    staid=rdbitu(&rd,12);
+
+    /* strings chained by length bytes (setup id after antenna descriptor) */
+    for (i=0;i<5;i++) {
+        if (bitrd_left(&rd)<(i==0?16:8)) break;
+        n=rdbitu(&rd,8);
+        if (bitrd_left(&rd)<8*n+(i==0?8:0)) break;
+        for (j=0;j<n;j++) {
+            c=(char)rdbitu(&rd,8);
+            if (j<31) str[i][j]=c;
         }
+        if (i==0) setup=rdbitu(&rd,8);
     }
-    else {
+    if (i<5) {
         trace(2,"rtcm3 1033 length error: len=%d\n",rtcm->len);
         return -1;
     }
@@ -1014,12 +1374,12 @@ static int decode_type1033(rtcm_t *rtcm)
     if (!test_staid(rtcm,staid)) return -1;
 
     sprintf(rtcm->sta.name,"%04d",staid);
-    strncpy(rtcm->sta.antdes, des,n ); rtcm->sta.antdes [n] ='\0';
+    strcpy(rtcm->sta.antdes ,des); /* des,...,rsn: up to 31 chars */
     rtcm->sta.antsetup=setup;
-    strncpy(rtcm->sta.antsno, sno,m ); rtcm->sta.antsno [m] ='\0';
-    strncpy(rtcm->sta.rectype,rec,n1); rtcm->sta.rectype[n1]='\0';
-    strncpy(rtcm->sta.recver, ver,n2); rtcm->sta.recver [n2]='\0';
-    strncpy(rtcm->sta.recsno, rsn,n3); rtcm->sta.recsno [n3]='\0';
+    strcpy(rtcm->sta.antsno ,sno);
+    strcpy(rtcm->sta.rectype,rec);
+    strcpy(rtcm->sta.recver ,ver);
+    strcpy(rtcm->sta.recsno ,rsn);
 
     trace(3,"rtcm3 1033: ant=%s:%s rec=%s:%s:%s\n",des,sno,rec,ver,rsn);
     return 5;
@@ -1057,43 +1417,14 @@ static int decode_type1039(rtcm_t *rtcm)
 /* decode type 1041: NavIC/IRNSS ephemerides ---------------------------------*/
 static int decode_type1041(rtcm_t *rtcm)
 {
+    bitrd_t rd;
     eph_t eph={0};
     double toc,sqrtA,tt;
     char *msg;
-    int i=24+12,prn,sat,week,sys=SYS_IRN;
-
-    if (i+482-12<=rtcm->len*8) {
-        prn       =getbitu(rtcm->buff,i, 6);              i+= 6;
-        week      =getbitu(rtcm->buff,i,10);              i+=10;
-        eph.f0    =getbits(rtcm->buff,i,22)*P2_31;        i+=22;
-        eph.f1    =getbits(rtcm->buff,i,16)*P2_43;        i+=16;
-        eph.f2    =getbits(rtcm->buff,i, 8)*P2_55;        i+= 8;
-        eph.sva   =getbitu(rtcm->buff,i, 4);              i+= 4;
-        toc       =getbitu(rtcm->buff,i,16)*16.0;         i+=16;
-        eph.tgd[0]=getbits(rtcm->buff,i, 8)*P2_31;        i+= 8;
-        eph.deln  =getbits(rtcm->buff,i,22)*P2_41*SC2RAD; i+=22;
-        eph.iode  =getbitu(rtcm->buff,i, 8);              i+= 8+10; /* IODEC */
-        eph.svh   =getbitu(rtcm->buff,i, 2);              i+= 2; /* L5+Sflag */
-        eph.cuc   =getbits(rtcm->buff,i,15)*P2_28;        i+=15;
-        eph.cus   =getbits(rtcm->buff,i,15)*P2_28;        i+=15;
-        eph.cic   =getbits(rtcm->buff,i,15)*P2_28;        i+=15;
-        eph.cis   =getbits(rtcm->buff,i,15)*P2_28;        i+=15;
-        eph.crc   =getbits(rtcm->buff,i,15)*0.0625;       i+=15;
-        eph.crs   =getbits(rtcm->buff,i,15)*0.0625;       i+=15;
-        eph.idot  =getbits(rtcm->buff,i,14)*P2_43*SC2RAD; i+=14;
-        eph.M0    =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.toes  =getbitu(rtcm->buff,i,16)*16.0;         i+=16;
-        eph.e     =getbitu(rtcm->buff,i,32)*P2_33;        i+=32;
-        sqrtA     =getbitu(rtcm->buff,i,32)*P2_19;        i+=32;
-        eph.OMG0  =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.omg   =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.OMGd  =getbits(rtcm->buff,i,22)*P2_41*SC2RAD; i+=22;
-        eph.i0    =getbits(rtcm->buff,i,32)*P2_31*SC2RAD;
-    }
-    else {
-        trace(2,"rtcm3 1041 length error: len=%d\n",rtcm->len);
-        return -1;
-    }
+    int prn,sat,week,sys=SYS_IRN;
+
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
+    MT1041(RD_FIELD)
     trace(4,"decode_type1041: prn=%d iode=%d toe=%.0f\n",prn,eph.iode,eph.toes);
 
     if (rtcm->outtype) {
@@ -1127,46 +1458,16 @@ static int decode_type1041(rtcm_t *rtcm)
 /* decode type 1044: QZSS ephemerides ----------------------------------------*/
 static int decode_type1044(rtcm_t *rtcm)
 {
+    bitrd_t rd;
     eph_t eph={0};
     double toc,sqrtA,tt;
     char *msg;
-    int i=24+12,prn,sat,week,sys=SYS_QZS;
-
-    if (i+473<=rtcm->len*8) {
-        prn       =getbitu(rtcm->buff,i, 4)+192;          i+= 4;
-        toc       =getbitu(rtcm->buff,i,16)*16.0;         i+=16;
-        eph.f2    =getbits(rtcm->buff,i, 8)*P2_55;        i+= 8;
-        eph.f1    =getbits(rtcm->buff,i,16)*P2_43;        i+=16;
-        eph.f0    =getbits(rtcm->buff,i,22)*P2_31;        i+=22;
-        eph.iode  =getbitu(rtcm->buff,i, 8);              i+= 8;
-        eph.crs   =getbits(rtcm->buff,i,16)*P2_5;         i+=16;
-        eph.deln  =getbits(rtcm->buff,i,16)*P2_43*SC2RAD; i+=16;
-        eph.M0    =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.cuc   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        eph.e     =getbitu(rtcm->buff,i,32)*P2_33;        i+=32;
-        eph.cus   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        sqrtA     =getbitu(rtcm->buff,i,32)*P2_19;        i+=32;
-        eph.toes  =getbitu(rtcm->buff,i,16)*16.0;         i+=16;
-        eph.cic   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        eph.OMG0  =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.cis   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        eph.i0    =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.crc   =getbits(rtcm->buff,i,16)*P2_5;         i+=16;
-        eph.omg   =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.OMGd  =getbits(rtcm->buff,i,24)*P2_43*SC2RAD; i+=24;
-        eph.idot  =getbits(rtcm->buff,i,14)*P2_43*SC2RAD; i+=14;
-        eph.code  =getbitu(rtcm->buff,i, 2);              i+= 2;
-        week      =getbitu(rtcm->buff,i,10);              i+=10;
-        eph.sva   =getbitu(rtcm->buff,i, 4);              i+= 4;
-        eph.svh   =getbitu(rtcm->buff,i, 6);              i+= 6;
-        eph.tgd[0]=getbits(rtcm->buff,i, 8)*P2_31;        i+= 8;
-        eph.iodc  =getbitu(rtcm->buff,i,10);              i+=10;
-        eph.fit   =getbitu(rtcm->buff,i, 1)?0.0:2.0; /* 0:2hr,1:>2hr */
-    }
-    else {
-        trace(2,"rtcm3 1044 length error: len=%d\n",rtcm->len);
-        return -1;
-    }
+    int prn,sat,week,fit,sys=SYS_QZS;
+
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
+    MT1044(RD_FIELD)
+    prn+=192;
+    eph.fit=fit?0.0:2.0; /* 0:2hr,1:>2hr */
     trace(4,"decode_type1044: prn=%d iode=%d toe=%.0f\n",prn,eph.iode,eph.toes);
 
     if (rtcm->outtype) {
@@ -1201,47 +1502,16 @@ static int decode_type1044(rtcm_t *rtcm)
 /* decode type 1045: Galileo F/NAV satellite ephemerides ---------------------*/
 static int decode_type1045(rtcm_t *rtcm)
 {
+    bitrd_t rd;
     eph_t eph={0};
     double toc,sqrtA,tt;
     char *msg;
-    int i=24+12,prn,sat,week,e5a_hs,e5a_dvs,rsv,sys=SYS_GAL;
+    int prn,sat,week,e5a_hs,e5a_dvs,sys=SYS_GAL;
 
     if (strstr(rtcm->opt,"-GALINAV")) return 0;
 
-    if (i+484<=rtcm->len*8) {
-        prn       =getbitu(rtcm->buff,i, 6);              i+= 6;
-        week      =getbitu(rtcm->buff,i,12);              i+=12; /* gst-week */
-        eph.iode  =getbitu(rtcm->buff,i,10);              i+=10;
-        eph.sva   =getbitu(rtcm->buff,i, 8);              i+= 8;
-        eph.idot  =getbits(rtcm->buff,i,14)*P2_43*SC2RAD; i+=14;
-        toc       =getbitu(rtcm->buff,i,14)*60.0;         i+=14;
-        eph.f2    =getbits(rtcm->buff,i, 6)*P2_59;        i+= 6;
-        eph.f1    =getbits(rtcm->buff,i,21)*P2_46;        i+=21;
-        eph.f0    =getbits(rtcm->buff,i,31)*P2_34;        i+=31;
-        eph.crs   =getbits(rtcm->buff,i,16)*P2_5;         i+=16;
-        eph.deln  =getbits(rtcm->buff,i,16)*P2_43*SC2RAD; i+=16;
-        eph.M0    =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.cuc   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        eph.e     =getbitu(rtcm->buff,i,32)*P2_33;        i+=32;
-        eph.cus   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        sqrtA     =getbitu(rtcm->buff,i,32)*P2_19;        i+=32;
-        eph.toes  =getbitu(rtcm->buff,i,14)*60.0;         i+=14;
-        eph.cic   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        eph.OMG0  =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.cis   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        eph.i0    =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.crc   =getbits(rtcm->buff,i,16)*P2_5;         i+=16;
-        eph.omg   =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.OMGd  =getbits(rtcm->buff,i,24)*P2_43*SC2RAD; i+=24;
-        eph.tgd[0]=getbits(rtcm->buff,i,10)*P2_32;        i+=10; /* E5a/E1 */
-        e5a_hs    =getbitu(rtcm->buff,i, 2);              i+= 2; /* OSHS */
-        e5a_dvs   =getbitu(rtcm->buff,i, 1);              i+= 1; /* OSDVS */
-        rsv       =getbitu(rtcm->buff,i, 7);
-    }
-    else {
-        trace(2,"rtcm3 1045 length error: len=%d\n",rtcm->len);
-        return -1;
-    }
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
+    MT1045(RD_FIELD)
     trace(4,"decode_type1045: prn=%d iode=%d toe=%.0f\n",prn,eph.iode,eph.toes);
 
     if (rtcm->outtype) {
@@ -1280,49 +1550,16 @@ static int decode_type1045(rtcm_t *rtcm)
 /* decode type 1046: Galileo I/NAV satellite ephemerides ---------------------*/
 static int decode_type1046(rtcm_t *rtcm)
 {
+    bitrd_t rd;
     eph_t eph={0};
     double toc,sqrtA,tt;
     char *msg;
-    int i=24+12,prn,sat,week,e5b_hs,e5b_dvs,e1_hs,e1_dvs,sys=SYS_GAL;
+    int prn,sat,week,e5b_hs,e5b_dvs,e1_hs,e1_dvs,sys=SYS_GAL;
 
     if (strstr(rtcm->opt,"-GALFNAV")) return 0;
 
-    if (i+492<=rtcm->len*8) {
-        prn       =getbitu(rtcm->buff,i, 6);              i+= 6;
-        week      =getbitu(rtcm->buff,i,12);              i+=12;
-        eph.iode  =getbitu(rtcm->buff,i,10);              i+=10;
-        eph.sva   =getbitu(rtcm->buff,i, 8);              i+= 8;
-        eph.idot  =getbits(rtcm->buff,i,14)*P2_43*SC2RAD; i+=14;
-        toc       =getbitu(rtcm->buff,i,14)*60.0;         i+=14;
-        eph.f2    =getbits(rtcm->buff,i, 6)*P2_59;        i+= 6;
-        eph.f1    =getbits(rtcm->buff,i,21)*P2_46;        i+=21;
-        eph.f0    =getbits(rtcm->buff,i,31)*P2_34;        i+=31;
-        eph.crs   =getbits(rtcm->buff,i,16)*P2_5;         i+=16;
-        eph.deln  =getbits(rtcm->buff,i,16)*P2_43*SC2RAD; i+=16;
-        eph.M0    =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.cuc   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        eph.e     =getbitu(rtcm->buff,i,32)*P2_33;        i+=32;
-        eph.cus   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        sqrtA     =getbitu(rtcm->buff,i,32)*P2_19;        i+=32;
-        eph.toes  =getbitu(rtcm->buff,i,14)*60.0;         i+=14;
-        eph.cic   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        eph.OMG0  =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.cis   =getbits(rtcm->buff,i,16)*P2_29;        i+=16;
-        eph.i0    =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.crc   =getbits(rtcm->buff,i,16)*P2_5;         i+=16;
-        eph.omg   =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.OMGd  =getbits(rtcm->buff,i,24)*P2_43*SC2RAD; i+=24;
-        eph.tgd[0]=getbits(rtcm->buff,i,10)*P2_32;        i+=10; /* E5a/E1 */
-        eph.tgd[1]=getbits(rtcm->buff,i,10)*P2_32;        i+=10; /* E5b/E1 */
-        e5b_hs    =getbitu(rtcm->buff,i, 2);              i+= 2; /* E5b OSHS */
-        e5b_dvs   =getbitu(rtcm->buff,i, 1);              i+= 1; /* E5b OSDVS */
-        e1_hs     =getbitu(rtcm->buff,i, 2);              i+= 2; /* E1 OSHS */
-        e1_dvs    =getbitu(rtcm->buff,i, 1);              i+= 1; /* E1 OSDVS */
-    }
-    else {
-        trace(2,"rtcm3 1046 length error: len=%d\n",rtcm->len);
-        return -1;
-    }
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
+    MT1046(RD_FIELD)
     trace(4,"decode_type1046: prn=%d iode=%d toe=%.0f\n",prn,eph.iode,eph.toes);
 
     if (rtcm->outtype) {
@@ -1361,45 +1598,14 @@ static int decode_type1046(rtcm_t *rtcm)
 /* decode type 1042/63: Beidou ephemerides -----------------------------------*/
 static int decode_type1042(rtcm_t *rtcm)
 {
+    bitrd_t rd;
     eph_t eph={0};
     double toc,sqrtA,tt;
     char *msg;
-    int i=24+12,prn,sat,week,sys=SYS_CMP;
-
-    if (i+499<=rtcm->len*8) {
-        prn       =getbitu(rtcm->buff,i, 6);              i+= 6;
-        week      =getbitu(rtcm->buff,i,13);              i+=13;
-        eph.sva   =getbitu(rtcm->buff,i, 4);              i+= 4;
-        eph.idot  =getbits(rtcm->buff,i,14)*P2_43*SC2RAD; i+=14;
-        eph.iode  =getbitu(rtcm->buff,i, 5);              i+= 5; /* AODE */
-        toc       =getbitu(rtcm->buff,i,17)*8.0;          i+=17;
-        eph.f2    =getbits(rtcm->buff,i,11)*P2_66;        i+=11;
-        eph.f1    =getbits(rtcm->buff,i,22)*P2_50;        i+=22;
-        eph.f0    =getbits(rtcm->buff,i,24)*P2_33;        i+=24;
-        eph.iodc  =getbitu(rtcm->buff,i, 5);              i+= 5; /* AODC */
-        eph.crs   =getbits(rtcm->buff,i,18)*P2_6;         i+=18;
-        eph.deln  =getbits(rtcm->buff,i,16)*P2_43*SC2RAD; i+=16;
-        eph.M0    =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.cuc   =getbits(rtcm->buff,i,18)*P2_31;        i+=18;
-        eph.e     =getbitu(rtcm->buff,i,32)*P2_33;        i+=32;
-        eph.cus   =getbits(rtcm->buff,i,18)*P2_31;        i+=18;
-        sqrtA     =getbitu(rtcm->buff,i,32)*P2_19;        i+=32;
-        eph.toes  =getbitu(rtcm->buff,i,17)*8.0;          i+=17;
-        eph.cic   =getbits(rtcm->buff,i,18)*P2_31;        i+=18;
-        eph.OMG0  =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.cis   =getbits(rtcm->buff,i,18)*P2_31;        i+=18;
-        eph.i0    =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.crc   =getbits(rtcm->buff,i,18)*P2_6;         i+=18;
-        eph.omg   =getbits(rtcm->buff,i,32)*P2_31*SC2RAD; i+=32;
-        eph.OMGd  =getbits(rtcm->buff,i,24)*P2_43*SC2RAD; i+=24;
-        eph.tgd[0]=getbits(rtcm->buff,i,10)*1E-10;        i+=10;
-        eph.tgd[1]=getbits(rtcm->buff,i,10)*1E-10;        i+=10;
-        eph.svh   =getbitu(rtcm->buff,i, 1);              i+= 1;
-    }
-    else {
-        trace(2,"rtcm3 1042 length error: len=%d\n",rtcm->len);
-        return -1;
-    }
+    int prn,sat,week,sys=SYS_CMP;
+
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
+    MT1042(RD_FIELD)
     trace(4,"decode_type1042: prn=%d iode=%d toe=%.0f\n",prn,eph.iode,eph.toes);
 
     if (rtcm->outtype) {
@@ -1431,58 +1637,79 @@ static int decode_type1042(rtcm_t *rtcm)
     rtcm->ephsat=sat;
     return 2;
 }
-/* decode SSR message epoch time ---------------------------------------------*/
-static int decode_ssr_epoch(rtcm_t *rtcm, int sys, int subtype)
+/* peek SSR message epoch time (tod for RTCM GLONASS SSR) --------------------*/
+static void peek_ssr_epoch(bitrd_t *rd, int sys, int subtype, double *t)
 {
-    double tod,tow;
-    int i=24+12;
-
     if (subtype==0) { /* RTCM SSR */
 
         if (sys==SYS_GLO) {
-            tod=getbitu(rtcm->buff,i,17); i+=17;
-            adjday_glot(rtcm,tod);
+            *t=rdbitu(rd,17);
         }
         else {
-            tow=getbitu(rtcm->buff,i,20); i+=20;
-            adjweek(rtcm,tow);
+            *t=rdbitu(rd,20);
         }
     }
     else { /* IGS SSR */
-        i+=3+8;
-        tow=getbitu(rtcm->buff,i,20); i+=20;
-        adjweek(rtcm,tow);
+        skipbits(rd,3+8);
+        *t=rdbitu(rd,20);
     }
-    return i;
+}
+/* peek SSR message header (ssr: SSR message number 1-7) ---------------------*/
+static int peek_ssr_head(bitrd_t *rd, int sys, int subtype, int ssr,
+                         rtcm_head_t *head, double *t)
+{
+    int ne,ns,nx;
+
+    /* refd (SSR 1,4) or dispersive bias and MW consistency (SSR 7) */
+    nx=(ssr==1||ssr==4)?1:(ssr==7?2:0);
+    ne=subtype>0?3+8+20:(sys==SYS_GLO?17:20);
+    ns=(subtype==0&&sys==SYS_QZS)?4:6;
+
+    if (bitrd_left(rd)<ne+29+nx+ns) return -1;
+    peek_ssr_epoch(rd,sys,subtype,t);
+    skipbits(rd,4);
+    head->sync=rdbitu(rd,1);
+    skipbits(rd,24+nx);
+    head->nsat=rdbitu(rd,ns);
+    return head->nsat;
+}
+/* decode SSR message epoch time ---------------------------------------------*/
+static void decode_ssr_epoch(rtcm_t *rtcm, bitrd_t *rd, int sys, int subtype)
+{
+    double t;
+
+    peek_ssr_epoch(rd,sys,subtype,&t);
+    if (subtype==0&&sys==SYS_GLO) adjday_glot(rtcm,t);
+    else adjweek(rtcm,t);
 }
 /* decode SSR 1,4 message header ---------------------------------------------*/
 static int decode_ssr1_head(rtcm_t *rtcm, int sys, int subtype, int *sync,
-                            int *iod, double *udint, int *refd, int *hsize)
+                            int *iod, double *udint, int *refd, bitrd_t *rd)
 {
     char *msg,tstr[64];
-    int i=24+12,nsat,udi,provid=0,solid=0,ns;
+    int nsat,udi,provid=0,solid=0,ns;
 
     if (subtype==0) { /* RTCM SSR */
         ns=(sys==SYS_QZS)?4:6;
-        if (i+((sys==SYS_GLO)?53:50+ns)>rtcm->len*8) return -1;
+        if (bitrd_left(rd)<((sys==SYS_GLO)?53:50+ns)) return -1;
     }
     else { /* IGS SSR */
         ns=6;
-        if (i+3+8+50+ns>rtcm->len*8) return -1;
+        if (bitrd_left(rd)<3+8+50+ns) return -1;
     }
-    i=decode_ssr_epoch(rtcm,sys,subtype);
-    udi   =getbitu(rtcm->buff,i, 4); i+= 4;
-    *sync =getbitu(rtcm->buff,i, 1); i+= 1;
+    decode_ssr_epoch(rtcm,rd,sys,subtype);
+    udi   =rdbitu(rd, 4);
+    *sync =rdbitu(rd, 1);
     if (subtype==0) { /* RTCM SSR */
-        *refd=getbitu(rtcm->buff,i,1); i+=1; /* satellite ref datum */
+        *refd=rdbitu(rd, 1); /* satellite ref datum */
     }
-    *iod  =getbitu(rtcm->buff,i, 4); i+= 4; /* IOD SSR */
-    provid=getbitu(rtcm->buff,i,16); i+=16; /* provider ID */
-    solid =getbitu(rtcm->buff,i, 4); i+= 4; /* solution ID */
+    *iod  =rdbitu(rd, 4); /* IOD SSR */
+    provid=rdbitu(rd,16); /* provider ID */
+    solid =rdbitu(rd, 4); /* solution ID */
     if (subtype>0) { /* IGS SSR */
-        *refd=getbitu(rtcm->buff,i,1); i+=1; /* global/regional CRS indicator */
+        *refd=rdbitu(rd, 1); /* global/regional CRS indicator */
     }
-    nsat  =getbitu(rtcm->buff,i,ns); i+=ns;
+    nsat  =rdbitu(rd,ns);
     *udint=ssrudint[udi];
 
     time2str(rtcm->time,tstr,2);
@@ -1494,31 +1721,30 @@ static int decode_ssr1_head(rtcm_t *rtcm, int sys, int subtype, int *sync,
         sprintf(msg," %s nsat=%2d iod=%2d udi=%2d sync=%d",tstr,nsat,*iod,udi,
                 *sync);
     }
-    *hsize=i;
     return nsat;
 }
 /* decode SSR 2,3,5,6 message header -----------------------------------------*/
 static int decode_ssr2_head(rtcm_t *rtcm, int sys, int subtype, int *sync,
-                            int *iod, double *udint, int *hsize)
+                            int *iod, double *udint, bitrd_t *rd)
 {
     char *msg,tstr[64];
-    int i=24+12,nsat,udi,provid=0,solid=0,ns;
+    int nsat,udi,provid=0,solid=0,ns;
 
     if (subtype==0) { /* RTCM SSR */
         ns=(sys==SYS_QZS)?4:6;
-        if (i+((sys==SYS_GLO)?52:49+ns)>rtcm->len*8) return -1;
+        if (bitrd_left(rd)<((sys==SYS_GLO)?52:49+ns)) return -1;
     }
     else {
         ns=6;
-        if (i+3+8+49+ns>rtcm->len*8) return -1;
-    }
-    i=decode_ssr_epoch(rtcm,sys,subtype);
-    udi   =getbitu(rtcm->buff,i, 4); i+= 4;
-    *sync =getbitu(rtcm->buff,i, 1); i+= 1;
-    *iod  =getbitu(rtcm->buff,i, 4); i+= 4;
-    provid=getbitu(rtcm->buff,i,16); i+=16; /* provider ID */
-    solid =getbitu(rtcm->buff,i, 4); i+= 4; /* solution ID */
-    nsat  =getbitu(rtcm->buff,i,ns); i+=ns;
+        if (bitrd_left(rd)<3+8+49+ns) return -1;
+    }
+    decode_ssr_epoch(rtcm,rd,sys,subtype);
+    udi   =rdbitu(rd, 4);
+    *sync =rdbitu(rd, 1);
+    *iod  =rdbitu(rd, 4);
+    provid=rdbitu(rd,16); /* provider ID */
+    solid =rdbitu(rd, 4); /* solution ID */
+    nsat  =rdbitu(rd,ns);
     *udint=ssrudint[udi];
 
     time2str(rtcm->time,tstr,2);
@@ -1530,18 +1756,19 @@ static int decode_ssr2_head(rtcm_t *rtcm, int sys, int subtype, int *sync,
         sprintf(msg," %s nsat=%2d iod=%2d udi=%2d sync=%d",tstr,nsat,*iod,udi,
                 *sync);
     }
-    *hsize=i;
     return nsat;
 }
 /* decode SSR 1: orbit corrections -------------------------------------------*/
 static int decode_ssr1(rtcm_t *rtcm, int sys, int subtype)
 {
+    bitrd_t rd;
     double udint,deph[3],ddeph[3];
-    int i,j,k,type,sync,iod,nsat,prn,sat,iode,iodcrc=0,refd=0,np,ni,nj,offp;
+    int j,k,type,sync,iod,nsat,prn,sat,iode,iodcrc=0,refd=0,np,ni,nj,offp;
 
-    type=getbitu(rtcm->buff,24,12);
+    type=getbitu(rtcm->pbuff,24,12);
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
 
-    if ((nsat=decode_ssr1_head(rtcm,sys,subtype,&sync,&iod,&udint,&refd,&i))<0) {
+    if ((nsat=decode_ssr1_head(rtcm,sys,subtype,&sync,&iod,&udint,&refd,&rd))<0) {
         trace(2,"rtcm3 %d length error: len=%d\n",type,rtcm->len);
         return -1;
     }
@@ -1559,16 +1786,16 @@ static int decode_ssr1(rtcm_t *rtcm, int sys, int subtype)
         if      (sys==SYS_CMP) offp=0;
         else if (sys==SYS_SBS) offp=119;
     }
-    for (j=0;j<nsat&&i+121+np+ni+nj<=rtcm->len*8;j++) {
-        prn     =getbitu(rtcm->buff,i,np)+offp; i+=np;
-        iode    =getbitu(rtcm->buff,i,ni);      i+=ni;
-        iodcrc  =getbitu(rtcm->buff,i,nj);      i+=nj;
-        deph [0]=getbits(rtcm->buff,i,22)*1E-4; i+=22;
-        deph [1]=getbits(rtcm->buff,i,20)*4E-4; i+=20;
-        deph [2]=getbits(rtcm->buff,i,20)*4E-4; i+=20;
-        ddeph[0]=getbits(rtcm->buff,i,21)*1E-6; i+=21;
-        ddeph[1]=getbits(rtcm->buff,i,19)*4E-6; i+=19;
-        ddeph[2]=getbits(rtcm->buff,i,19)*4E-6; i+=19;
+    for (j=0;j<nsat&&bitrd_left(&rd)>=121+np+ni+nj;j++) {
+        prn     =rdbitu(&rd,np)+offp;
+        iode    =rdbitu(&rd,ni);
+        iodcrc  =rdbitu(&rd,nj);
+        deph [0]=rdbits(&rd,22)*1E-4;
+        deph [1]=rdbits(&rd,20)*4E-4;
+        deph [2]=rdbits(&rd,20)*4E-4;
+        ddeph[0]=rdbits(&rd,21)*1E-6;
+        ddeph[1]=rdbits(&rd,19)*4E-6;
+        ddeph[2]=rdbits(&rd,19)*4E-6;
 
         if (!(sat=satno(sys,prn))) {
             trace(2,"rtcm3 %d satellite number error: prn=%d\n",type,prn);
@@ -1592,12 +1819,14 @@ static int decode_ssr1(rtcm_t *rtcm, int sys, int subtype)
 /* decode SSR 2: clock corrections -------------------------------------------*/
 static int decode_ssr2(rtcm_t *rtcm, int sys, int subtype)
 {
+    bitrd_t rd;
     double udint,dclk[3];
-    int i,j,k,type,sync,iod,nsat,prn,sat,np,offp;
+    int j,k,type,sync,iod,nsat,prn,sat,np,offp;
 
-    type=getbitu(rtcm->buff,24,12);
+    type=getbitu(rtcm->pbuff,24,12);
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
 
-    if ((nsat=decode_ssr2_head(rtcm,sys,subtype,&sync,&iod,&udint,&i))<0) {
+    if ((nsat=decode_ssr2_head(rtcm,sys,subtype,&sync,&iod,&udint,&rd))<0) {
         trace(2,"rtcm3 %d length error: len=%d\n",type,rtcm->len);
         return -1;
     }
@@ -1615,11 +1844,11 @@ static int decode_ssr2(rtcm_t *rtcm, int sys, int subtype)
         if      (sys==SYS_CMP) offp=0;
         else if (sys==SYS_SBS) offp=119;
     }
-    for (j=0;j<nsat&&i+70+np<=rtcm->len*8;j++) {
-        prn    =getbitu(rtcm->buff,i,np)+offp; i+=np;
-        dclk[0]=getbits(rtcm->buff,i,22)*1E-4; i+=22;
-        dclk[1]=getbits(rtcm->buff,i,21)*1E-6; i+=21;
-        dclk[2]=getbits(rtcm->buff,i,27)*2E-8; i+=27;
+    for (j=0;j<nsat&&bitrd_left(&rd)>=70+np;j++) {
+        prn    =rdbitu(&rd,np)+offp;
+        dclk[0]=rdbits(&rd,22)*1E-4;
+        dclk[1]=rdbits(&rd,21)*1E-6;
+        dclk[2]=rdbits(&rd,27)*2E-8;
 
         if (!(sat=satno(sys,prn))) {
             trace(2,"rtcm3 %d satellite number error: prn=%d\n",type,prn);
@@ -1639,13 +1868,15 @@ static int decode_ssr2(rtcm_t *rtcm, int sys, int subtype)
 /* decode SSR 3: satellite code biases ---------------------------------------*/
 static int decode_ssr3(rtcm_t *rtcm, int sys, int subtype)
 {
+    bitrd_t rd;
     const uint8_t *sigs;
     double udint,bias,cbias[MAXCODE];
-    int i,j,k,type,mode,sync,iod,nsat,prn,sat,nbias,np,offp;
+    int j,k,type,mode,sync,iod,nsat,prn,sat,nbias,np,offp;
 
-    type=getbitu(rtcm->buff,24,12);
+    type=getbitu(rtcm->pbuff,24,12);
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
 
-    if ((nsat=decode_ssr2_head(rtcm,sys,subtype,&sync,&iod,&udint,&i))<0) {
+    if ((nsat=decode_ssr2_head(rtcm,sys,subtype,&sync,&iod,&udint,&rd))<0) {
         trace(2,"rtcm3 %d length error: len=%d\n",type,rtcm->len);
         return -1;
     }
@@ -1663,14 +1894,14 @@ static int decode_ssr3(rtcm_t *rtcm, int sys, int subtype)
         if      (sys==SYS_CMP) offp=0;
         else if (sys==SYS_SBS) offp=119;
     }
-    for (j=0;j<nsat&&i+5+np<=rtcm->len*8;j++) {
-        prn  =getbitu(rtcm->buff,i,np)+offp; i+=np;
-        nbias=getbitu(rtcm->buff,i, 5);      i+= 5;
+    for (j=0;j<nsat&&bitrd_left(&rd)>=5+np;j++) {
+        prn  =rdbitu(&rd,np)+offp;
+        nbias=rdbitu(&rd, 5);
 
         for (k=0;k<MAXCODE;k++) cbias[k]=0.0;
-        for (k=0;k<nbias&&i+19<=rtcm->len*8;k++) {
-            mode=getbitu(rtcm->buff,i, 5);      i+= 5;
-            bias=getbits(rtcm->buff,i,14)*0.01; i+=14;
+        for (k=0;k<nbias&&bitrd_left(&rd)>=19;k++) {
+            mode=rdbitu(&rd, 5);
+            bias=rdbits(&rd,14)*0.01;
             if (sigs[mode]) {
                 cbias[sigs[mode]-1]=(float)bias;
             }
@@ -1696,12 +1927,14 @@ static int decode_ssr3(rtcm_t *rtcm, int sys, int subtype)
 /* decode SSR 4: combined orbit and clock corrections ------------------------*/
 static int decode_ssr4(rtcm_t *rtcm, int sys, int subtype)
 {
+    bitrd_t rd;
     double udint,deph[3],ddeph[3],dclk[3];
-    int i,j,k,type,nsat,sync,iod,prn,sat,iode,iodcrc=0,refd=0,np,ni,nj,offp;
+    int j,k,type,nsat,sync,iod,prn,sat,iode,iodcrc=0,refd=0,np,ni,nj,offp;
 
-    type=getbitu(rtcm->buff,24,12);
+    type=getbitu(rtcm->pbuff,24,12);
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
 
-    if ((nsat=decode_ssr1_head(rtcm,sys,subtype,&sync,&iod,&udint,&refd,&i))<0) {
+    if ((nsat=decode_ssr1_head(rtcm,sys,subtype,&sync,&iod,&udint,&refd,&rd))<0) {
         trace(2,"rtcm3 %d length error: len=%d\n",type,rtcm->len);
         return -1;
     }
@@ -1719,20 +1952,20 @@ static int decode_ssr4(rtcm_t *rtcm, int sys, int subtype)
         if      (sys==SYS_CMP) offp=0;
         else if (sys==SYS_SBS) offp=119;
     }
-    for (j=0;j<nsat&&i+191+np+ni+nj<=rtcm->len*8;j++) {
-        prn     =getbitu(rtcm->buff,i,np)+offp; i+=np;
-        iode    =getbitu(rtcm->buff,i,ni);      i+=ni;
-        iodcrc  =getbitu(rtcm->buff,i,nj);      i+=nj;
-        deph [0]=getbits(rtcm->buff,i,22)*1E-4; i+=22;
-        deph [1]=getbits(rtcm->buff,i,20)*4E-4; i+=20;
-        deph [2]=getbits(rtcm->buff,i,20)*4E-4; i+=20;
-        ddeph[0]=getbits(rtcm->buff,i,21)*1E-6; i+=21;
-        ddeph[1]=getbits(rtcm->buff,i,19)*4E-6; i+=19;
-        ddeph[2]=getbits(rtcm->buff,i,19)*4E-6; i+=19;
-
-        dclk [0]=getbits(rtcm->buff,i,22)*1E-4; i+=22;
-        dclk [1]=getbits(rtcm->buff,i,21)*1E-6; i+=21;
-        dclk [2]=getbits(rtcm->buff,i,27)*2E-8; i+=27;
+    for (j=0;j<nsat&&bitrd_left(&rd)>=191+np+ni+nj;j++) {
+        prn     =rdbitu(&rd,np)+offp;
+        iode    =rdbitu(&rd,ni);
+        iodcrc  =rdbitu(&rd,nj);
+        deph [0]=rdbits(&rd,22)*1E-4;
+        deph [1]=rdbits(&rd,20)*4E-4;
+        deph [2]=rdbits(&rd,20)*4E-4;
+        ddeph[0]=rdbits(&rd,21)*1E-6;
+        ddeph[1]=rdbits(&rd,19)*4E-6;
+        ddeph[2]=rdbits(&rd,19)*4E-6;
+
+        dclk [0]=rdbits(&rd,22)*1E-4;
+        dclk [1]=rdbits(&rd,21)*1E-6;
+        dclk [2]=rdbits(&rd,27)*2E-8;
 
         if (!(sat=satno(sys,prn))) {
             trace(2,"rtcm3 %d satellite number error: prn=%d\n",type,prn);
@@ -1757,12 +1990,14 @@ static int decode_ssr4(rtcm_t *rtcm, int sys, int subtype)
 /* decode SSR 5: URA ---------------------------------------------------------*/
 static int decode_ssr5(rtcm_t *rtcm, int sys, int subtype)
 {
+    bitrd_t rd;
     double udint;
-    int i,j,type,nsat,sync,iod,prn,sat,ura,np,offp;
+    int j,type,nsat,sync,iod,prn,sat,ura,np,offp;
 
-    type=getbitu(rtcm->buff,24,12);
+    type=getbitu(rtcm->pbuff,24,12);
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
 
-    if ((nsat=decode_ssr2_head(rtcm,sys,subtype,&sync,&iod,&udint,&i))<0) {
+    if ((nsat=decode_ssr2_head(rtcm,sys,subtype,&sync,&iod,&udint,&rd))<0) {
         trace(2,"rtcm3 %d length error: len=%d\n",type,rtcm->len);
         return -1;
     }
@@ -1780,9 +2015,9 @@ static int decode_ssr5(rtcm_t *rtcm, int sys, int subtype)
         if      (sys==SYS_CMP) offp=0;
         else if (sys==SYS_SBS) offp=119;
     }
-    for (j=0;j<nsat&&i+6+np<=rtcm->len*8;j++) {
-        prn=getbitu(rtcm->buff,i,np)+offp; i+=np;
-        ura=getbitu(rtcm->buff,i, 6);      i+= 6;
+    for (j=0;j<nsat&&bitrd_left(&rd)>=6+np;j++) {
+        prn=rdbitu(&rd,np)+offp;
+        ura=rdbitu(&rd, 6);
 
         if (!(sat=satno(sys,prn))) {
             trace(2,"rtcm3 %d satellite number error: prn=%d\n",type,prn);
@@ -1799,12 +2034,14 @@ static int decode_ssr5(rtcm_t *rtcm, int sys, int subtype)
 /* decode SSR 6: high rate clock correction ----------------------------------*/
 static int decode_ssr6(rtcm_t *rtcm, int sys, int subtype)
 {
+    bitrd_t rd;
     double udint,hrclk;
-    int i,j,type,nsat,sync,iod,prn,sat,np,offp;
+    int j,type,nsat,sync,iod,prn,sat,np,offp;
 
-    type=getbitu(rtcm->buff,24,12);
+    type=getbitu(rtcm->pbuff,24,12);
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
 
-    if ((nsat=decode_ssr2_head(rtcm,sys,subtype,&sync,&iod,&udint,&i))<0) {
+    if ((nsat=decode_ssr2_head(rtcm,sys,subtype,&sync,&iod,&udint,&rd))<0) {
         trace(2,"rtcm3 %d length error: len=%d\n",type,rtcm->len);
         return -1;
     }
@@ -1822,9 +2059,9 @@ static int decode_ssr6(rtcm_t *rtcm, int sys, int subtype)
         if      (sys==SYS_CMP) offp=0;
         else if (sys==SYS_SBS) offp=119;
     }
-    for (j=0;j<nsat&&i+22+np<=rtcm->len*8;j++) {
-        prn  =getbitu(rtcm->buff,i,np)+offp; i+=np;
-        hrclk=getbits(rtcm->buff,i,22)*1E-4; i+=22;
+    for (j=0;j<nsat&&bitrd_left(&rd)>=22+np;j++) {
+        prn  =rdbitu(&rd,np)+offp;
+        hrclk=rdbits(&rd,22)*1E-4;
 
         if (!(sat=satno(sys,prn))) {
             trace(2,"rtcm3 %d satellite number error: prn=%d\n",type,prn);
@@ -1841,28 +2078,28 @@ static int decode_ssr6(rtcm_t *rtcm, int sys, int subtype)
 /* decode SSR 7 message header -----------------------------------------------*/
 static int decode_ssr7_head(rtcm_t *rtcm, int sys, int subtype, int *sync,
                             int *iod, double *udint, int *dispe, int *mw,
-                            int *hsize)
+                            bitrd_t *rd)
 {
     char *msg,tstr[64];
-    int i=24+12,nsat,udi,provid=0,solid=0,ns;
+    int nsat,udi,provid=0,solid=0,ns;
 
     if (subtype==0) { /* RTCM SSR */
         ns=(sys==SYS_QZS)?4:6;
-        if (i+((sys==SYS_GLO)?54:51+ns)>rtcm->len*8) return -1;
+        if (bitrd_left(rd)<((sys==SYS_GLO)?54:51+ns)) return -1;
     }
     else { /* IGS SSR */
         ns=6;
-        if (i+3+8+51+ns>rtcm->len*8) return -1;
-    }
-    i=decode_ssr_epoch(rtcm,sys,subtype);
-    udi   =getbitu(rtcm->buff,i, 4); i+= 4;
-    *sync =getbitu(rtcm->buff,i, 1); i+= 1;
-    *iod  =getbitu(rtcm->buff,i, 4); i+= 4;
-    provid=getbitu(rtcm->buff,i,16); i+=16; /* provider ID */
-    solid =getbitu(rtcm->buff,i, 4); i+= 4; /* solution ID */
-    *dispe=getbitu(rtcm->buff,i, 1); i+= 1; /* dispersive bias consistency ind */
-    *mw   =getbitu(rtcm->buff,i, 1); i+= 1; /* MW consistency indicator */
-    nsat  =getbitu(rtcm->buff,i,ns); i+=ns;
+        if (bitrd_left(rd)<3+8+51+ns) return -1;
+    }
+    decode_ssr_epoch(rtcm,rd,sys,subtype);
+    udi   =rdbitu(rd, 4);
+    *sync =rdbitu(rd, 1);
+    *iod  =rdbitu(rd, 4);
+    provid=rdbitu(rd,16); /* provider ID */
+    solid =rdbitu(rd, 4); /* solution ID */
+    *dispe=rdbitu(rd, 1); /* dispersive bias consistency ind */
+    *mw   =rdbitu(rd, 1); /* MW consistency indicator */
+    nsat  =rdbitu(rd,ns);
     *udint=ssrudint[udi];
 
     time2str(rtcm->time,tstr,2);
@@ -1874,21 +2111,22 @@ static int decode_ssr7_head(rtcm_t *rtcm, int sys, int subtype, int *sync,
         sprintf(msg," %s nsat=%2d iod=%2d udi=%2d sync=%d",tstr,nsat,*iod,udi,
                 *sync);
     }
-    *hsize=i;
     return nsat;
 }
 /* decode SSR 7: phase bias --------------------------------------------------*/
 static int decode_ssr7(rtcm_t *rtcm, int sys, int subtype)
 {
+    bitrd_t rd;
     const uint8_t *sigs;
     double udint,bias,std=0.0,pbias[MAXCODE],stdpb[MAXCODE];
-    int i,j,k,type,mode,sync,iod,nsat,prn,sat,nbias,np,mw,offp,sii,swl;
+    int j,k,type,mode,sync,iod,nsat,prn,sat,nbias,np,mw,offp,sii,swl;
     int dispe,sdc,yaw_ang,yaw_rate;
 
-    type=getbitu(rtcm->buff,24,12);
+    type=getbitu(rtcm->pbuff,24,12);
+    init_bitrd(&rd,rtcm->pbuff,rtcm->len,24+12);
 
     if ((nsat=decode_ssr7_head(rtcm,sys,subtype,&sync,&iod,&udint,&dispe,&mw,
-                               &i))<0) {
+                               &rd))<0) {
         trace(2,"rtcm3 %d length error: len=%d\n",type,rtcm->len);
         return -1;
     }
@@ -1905,21 +2143,21 @@ static int decode_ssr7(rtcm_t *rtcm, int sys, int subtype)
         if      (sys==SYS_CMP) offp=0;
         else if (sys==SYS_SBS) offp=119;
     }
-    for (j=0;j<nsat&&i+5+17+np<=rtcm->len*8;j++) {
-        prn     =getbitu(rtcm->buff,i,np)+offp; i+=np;
-        nbias   =getbitu(rtcm->buff,i, 5);      i+= 5;
-        yaw_ang =getbitu(rtcm->buff,i, 9);      i+= 9;
-        yaw_rate=getbits(rtcm->buff,i, 8);      i+= 8;
+    for (j=0;j<nsat&&bitrd_left(&rd)>=5+17+np;j++) {
+        prn     =rdbitu(&rd,np)+offp;
+        nbias   =rdbitu(&rd, 5);
+        yaw_ang =rdbitu(&rd, 9);
+        yaw_rate=rdbits(&rd, 8);
 
         for (k=0;k<MAXCODE;k++) pbias[k]=stdpb[k]=0.0;
-        for (k=0;k<nbias&&i+((subtype==0)?49:32)<=rtcm->len*8;k++) {
-            mode=getbitu(rtcm->buff,i, 5); i+= 5;
-            sii =getbitu(rtcm->buff,i, 1); i+= 1; /* integer-indicator */
-            swl =getbitu(rtcm->buff,i, 2); i+= 2; /* WL integer-indicator */
-            sdc =getbitu(rtcm->buff,i, 4); i+= 4; /* discontinuity counter */
-            bias=getbits(rtcm->buff,i,20); i+=20; /* phase bias (m) */
+        for (k=0;k<nbias&&bitrd_left(&rd)>=((subtype==0)?49:32);k++) {
+            mode=rdbitu(&rd, 5);
+            sii =rdbitu(&rd, 1); /* integer-indicator */
+            swl =rdbitu(&rd, 2); /* WL integer-indicator */
+            sdc =rdbitu(&rd, 4); /* discontinuity counter */
+            bias=rdbits(&rd,20); /* phase bias (m) */
             if (subtype==0) {
-                std=getbitu(rtcm->buff,i,17); i+=17; /* phase bias std-dev (m) */
+                std=rdbitu(&rd,17); /* phase bias std-dev (m) */
             }
             if (sigs[mode]) {
                 pbias[sigs[mode]-1]=bias*0.0001; /* (m) */
@@ -1947,8 +2185,8 @@ static int decode_ssr7(rtcm_t *rtcm, int sys, int subtype)
     return 20;
 }
 /* get signal index ----------------------------------------------------------*/
-static void sigindex(int sys, const uint8_t *code, int n, const char *opt,
-                     int *idx)
+static void sigindex(int sys, const uint8_t *code, int n,
+                     const uint8_t *codepri, int *idx)
 {
     int i,nex,pri,pri_h[8]={0},index[8]={0},ex[32]={0};
 
@@ -1961,7 +2199,7 @@ static void sigindex(int sys, const uint8_t *code, int n, const char *opt,
             continue;
         }
         /* code priority */
-        pri=getcodepri(sys,code[i],opt);
+        pri=codepri[code[i]];
 
         /* select highest priority signal */
         if (pri>pri_h[idx[i]]) {
@@ -1984,58 +2222,98 @@ static void sigindex(int sys, const uint8_t *code, int n, const char *opt,
 #endif
     }
 }
-/* save obs data in MSM message ----------------------------------------------*/
-static void save_msm_obs(rtcm_t *rtcm, int sys, msm_h_t *h, const double *r,
-                         const double *pr, const double *cp, const double *rr,
-                         const double *rrf, const double *cnr, const int *lock,
-                         const int *ex, const int *half)
+/* get MSM signal mapping -----------------------------------------------------
+* get obs codes and obs data indices of the signals in MSM message
+* args   : rtcm_t *rtcm     IO  rtcm control struct
+*          int    sys       I   navigation system
+*          msm_h_t *h       I   msm header
+* return : signal mapping (NULL: no mapping)
+* notes  : the mapping is cached per navigation system and rebuilt when the
+*          signal mask, the options (rtcm->opt) or the code priorities
+*          (setcodepri()) are changed. the code priorities are looked up in
+*          the table by getcodepris() rebuilt with the options.
+*-----------------------------------------------------------------------------*/
+static const rtcm_msmsig_t *msm_signal(rtcm_t *rtcm, int sys, const msm_h_t *h)
 {
-    const char *sig[32];
-    double tt,freq;
-    uint8_t code[32];
-    char *msm_type="",*q=NULL;
-    int i,j,k,type,prn,sat,fcn,index=0,idx[32];
-
-    type=getbitu(rtcm->buff,24,12);
+    rtcm_msmsig_t *m;
+    const uint8_t *sig;
+    char *q;
+    uint32_t ver;
+    int i,type;
 
     switch (sys) {
-        case SYS_GPS: msm_type=q=rtcm->msmtype[0]; break;
-        case SYS_GLO: msm_type=q=rtcm->msmtype[1]; break;
-        case SYS_GAL: msm_type=q=rtcm->msmtype[2]; break;
-        case SYS_QZS: msm_type=q=rtcm->msmtype[3]; break;
-        case SYS_SBS: msm_type=q=rtcm->msmtype[4]; break;
-        case SYS_CMP: msm_type=q=rtcm->msmtype[5]; break;
-        case SYS_IRN: msm_type=q=rtcm->msmtype[6]; break;
-    }
-    /* id to signal */
+        case SYS_GPS: i=0; sig=msm_sig_gps; break;
+        case SYS_GLO: i=1; sig=msm_sig_glo; break;
+        case SYS_GAL: i=2; sig=msm_sig_gal; break;
+        case SYS_QZS: i=3; sig=msm_sig_qzs; break;
+        case SYS_SBS: i=4; sig=msm_sig_sbs; break;
+        case SYS_CMP: i=5; sig=msm_sig_cmp; break;
+        case SYS_IRN: i=6; sig=msm_sig_irn; break;
+        default: return NULL;
+    }
+    m=rtcm->msmsig+i;
+    q=rtcm->msmtype[i];
+
+    if (strcmp(rtcm->msmopt,rtcm->opt)) { /* options changed */
+        for (i=0;i<7;i++) rtcm->msmsig[i].priver=0;
+        strcpy(rtcm->msmopt,rtcm->opt);
+    }
+    if (m->priver!=(ver=getcodepriver())) { /* code priorities changed */
+        getcodepris(sys,rtcm->opt,m->pri);
+        m->priver=ver;
+        m->nsig=-1;
+    }
+    if (m->nsig==h->nsig&&m->mask==h->sigmask) return m;
+
+    type=getbitu(rtcm->pbuff,24,12);
+    *q='\0';
+
+    /* signal id to obs code */
     for (i=0;i<h->nsig;i++) {
-        switch (sys) {
-            case SYS_GPS: sig[i]=msm_sig_gps[h->sigs[i]-1]; break;
-            case SYS_GLO: sig[i]=msm_sig_glo[h->sigs[i]-1]; break;
-            case SYS_GAL: sig[i]=msm_sig_gal[h->sigs[i]-1]; break;
-            case SYS_QZS: sig[i]=msm_sig_qzs[h->sigs[i]-1]; break;
-            case SYS_SBS: sig[i]=msm_sig_sbs[h->sigs[i]-1]; break;
-            case SYS_CMP: sig[i]=msm_sig_cmp[h->sigs[i]-1]; break;
-            case SYS_IRN: sig[i]=msm_sig_irn[h->sigs[i]-1]; break;
-            default: sig[i]=""; break;
-        }
-        /* signal to rinex obs type */
-        code[i]=obs2code(sig[i]);
-        idx[i]=code2idx(sys,code[i]);
-
-        if (code[i]!=CODE_NONE) {
-            if (q) q+=sprintf(q,"L%s%s",sig[i],i<h->nsig-1?",":"");
+        m->code[i]=sig[h->sigs[i]-1];
+        m->idx[i]=code2idx(sys,m->code[i]);
+        m->freq[i]=code2freq(sys,m->code[i],0);
+
+        if (m->code[i]!=CODE_NONE) {
+            q+=sprintf(q,"L%s%s",code2obs(m->code[i]),i<h->nsig-1?",":"");
         }
         else {
-            if (q) q+=sprintf(q,"(%d)%s",h->sigs[i],i<h->nsig-1?",":"");
+            q+=sprintf(q,"(%d)%s",h->sigs[i],i<h->nsig-1?",":"");
 
             trace(2,"rtcm3 %d: unknown signal id=%2d\n",type,h->sigs[i]);
         }
     }
-    trace(3,"rtcm3 %d: signals=%s\n",type,msm_type);
+    trace(3,"rtcm3 %d: signals=%s\n",type,rtcm->msmtype[m-rtcm->msmsig]);
 
     /* get signal index */
-    sigindex(sys,code,h->nsig,rtcm->opt,idx);
+    sigindex(sys,m->code,h->nsig,m->pri,m->idx);
+
+    m->nsig=h->nsig;
+    m->mask=h->sigmask;
+    return m;
+}
+/* save obs data in MSM message ----------------------------------------------*/
+static void save_msm_obs(rtcm_t *rtcm, int sys, int msm, const msm_h_t *h,
+                         const msm_d_t *d)
+{
+    const rtcm_msmsig_t *m;
+    const int hres=msm>=6,dop=msm==5||msm==7; /* high-res, doppler (MSM 5,7) */
+    const int pr_inv=hres?-524288:-16384,cp_inv=hres?-8388608:-2097152;
+    const double pr_unit=(hres?P2_29:P2_24)*RANGE_MS;
+    const double cp_unit=(hres?P2_31:P2_29)*RANGE_MS;
+    const double cnr_unit=hres?0.0625:1.0;
+    const uint8_t *code;
+    const int *idx;
+    const double *freq;
+    obsd_t *data;
+    double tt,r,rr,freq_glo[32];
+    int i,j,k,type,prn,sat,fcn,index=0;
+
+    type=getbitu(rtcm->pbuff,24,12);
+
+    if (!(m=msm_signal(rtcm,sys,h))) return;
+    code=m->code;
+    idx=m->idx;
 
     for (i=j=0;i<h->nsat;i++) {
 
@@ -2053,11 +2331,14 @@ static void save_msm_obs(rtcm_t *rtcm, int sys, msm_h_t *h, const double *r,
         else {
             trace(2,"rtcm3 %d satellite error: prn=%d\n",type,prn);
         }
-        fcn=0;
-        if (sys==SYS_GLO) {
+        r=d->rng[i]!=255?d->rng[i]*RANGE_MS:0.0;
+        if (r!=0.0) r+=d->rng_m[i]*P2_10*RANGE_MS;
+        rr=dop&&d->rate[i]!=-8192?d->rate[i]*1.0:0.0;
+        freq=m->freq;
+        if (sys==SYS_GLO&&sat) { /* fcn tables indexed by valid slot number */
             fcn=-8; /* no glonass fcn info */
-            if (ex&&ex[i]<=13) {
-                fcn=ex[i]-7;
+            if (dop&&d->ex[i]<=13) {
+                fcn=d->ex[i]-7;
                 if (!rtcm->nav.glo_fcn[prn-1]) {
                     rtcm->nav.glo_fcn[prn-1]=fcn+8; /* fcn+8 */
                 }
@@ -2068,84 +2349,109 @@ static void save_msm_obs(rtcm_t *rtcm, int sys, msm_h_t *h, const double *r,
             else if (rtcm->nav.glo_fcn[prn-1]>0) {
                 fcn=rtcm->nav.glo_fcn[prn-1]-8;
             }
+            /* frequencies of signals by frequency channel number */
+            for (k=0;k<h->nsig;k++) {
+                freq_glo[k]=fcn<-7?0.0:code2freq(sys,code[k],fcn);
+            }
+            freq=freq_glo;
         }
         for (k=0;k<h->nsig;k++) {
             if (!h->cellmask[k+i*h->nsig]) continue;
 
             if (sat&&index>=0&&idx[k]>=0) {
-                freq=fcn<-7?0.0:code2freq(sys,code[k],fcn);
+                data=rtcm->obs.data+index;
 
                 /* pseudorange (m) */
-                if (r[i]!=0.0&&pr[j]>-1E12) {
-                    rtcm->obs.data[index].P[idx[k]]=r[i]+pr[j];
+                if (r!=0.0&&d->pr[j]!=pr_inv) {
+                    data->P[idx[k]]=r+d->pr[j]*pr_unit;
                 }
                 /* carrier-phase (cycle) */
-                if (r[i]!=0.0&&cp[j]>-1E12) {
-                    rtcm->obs.data[index].L[idx[k]]=(r[i]+cp[j])*freq/CLIGHT;
+                if (r!=0.0&&d->cp[j]!=cp_inv) {
+                    data->L[idx[k]]=(r+d->cp[j]*cp_unit)*freq[k]/CLIGHT;
                 }
                 /* doppler (hz) */
-                if (rr&&rrf&&rrf[j]>-1E12) {
-                    rtcm->obs.data[index].D[idx[k]]=
-                        (float)(-(rr[i]+rrf[j])*freq/CLIGHT);
+                if (dop&&d->rrf[j]!=-16384) {
+                    data->D[idx[k]]=
+                        (float)(-(rr+d->rrf[j]*0.0001)*freq[k]/CLIGHT);
                 }
-                rtcm->obs.data[index].LLI[idx[k]]=
-                    lossoflock(rtcm,sat,idx[k],lock[j])+(half[j]?3:0);
-                rtcm->obs.data[index].SNR [idx[k]]=(uint16_t)(cnr[j]/SNR_UNIT+0.5);
-                rtcm->obs.data[index].code[idx[k]]=code[k];
+                data->LLI[idx[k]]=
+                    lossoflock(rtcm,sat,idx[k],d->lock[j])+(d->half[j]?3:0);
+                data->SNR [idx[k]]=(uint16_t)(d->cnr[j]*cnr_unit/SNR_UNIT+0.5);
+                data->code[idx[k]]=code[k];
             }
             j++;
         }
     }
 }
-/* decode type MSM message header --------------------------------------------*/
-static int decode_msm_head(rtcm_t *rtcm, int sys, int *sync, int *iod,
-                           msm_h_t *h, int *hsize)
+/* MSM message system (index: (type-1070)/10) --------------------------------*/
+static const int msm_sys[]={
+    SYS_GPS,SYS_GLO,SYS_GAL,SYS_SBS,SYS_QZS,SYS_CMP,SYS_IRN
+};
+/* peek type MSM message header (tod for GLONASS) ----------------------------*/
+static int peek_msm_head(bitrd_t *rd, int sys, rtcm_head_t *head, double *t,
+                         int *iod, msm_h_t *h)
 {
     msm_h_t h0={0};
-    double tow,tod;
-    char *msg,tstr[64];
-    int i=24,j,dow,mask,staid,type,ncell=0;
-
-    type=getbitu(rtcm->buff,i,12); i+=12;
+    uint32_t mask;
+    int i,j;
 
     *h=h0;
-    if (i+157<=rtcm->len*8) {
-        staid     =getbitu(rtcm->buff,i,12);       i+=12;
+    if (bitrd_left(rd)<157) return -1;
+    head->staid=rdbitu(rd,12);
 
-        if (sys==SYS_GLO) {
-            dow   =getbitu(rtcm->buff,i, 3);       i+= 3;
-            tod   =getbitu(rtcm->buff,i,27)*0.001; i+=27;
-            adjday_glot(rtcm,tod);
-        }
-        else if (sys==SYS_CMP) {
-            tow   =getbitu(rtcm->buff,i,30)*0.001; i+=30;
-            tow+=14.0; /* BDT -> GPST */
-            adjweek(rtcm,tow);
-        }
-        else {
-            tow   =getbitu(rtcm->buff,i,30)*0.001; i+=30;
-            adjweek(rtcm,tow);
-        }
-        *sync     =getbitu(rtcm->buff,i, 1);       i+= 1;
-        *iod      =getbitu(rtcm->buff,i, 3);       i+= 3;
-        h->time_s =getbitu(rtcm->buff,i, 7);       i+= 7;
-        h->clk_str=getbitu(rtcm->buff,i, 2);       i+= 2;
-        h->clk_ext=getbitu(rtcm->buff,i, 2);       i+= 2;
-        h->smooth =getbitu(rtcm->buff,i, 1);       i+= 1;
-        h->tint_s =getbitu(rtcm->buff,i, 3);       i+= 3;
-        for (j=1;j<=64;j++) {
-            mask=getbitu(rtcm->buff,i,1); i+=1;
-            if (mask) h->sats[h->nsat++]=j;
-        }
+    if (sys==SYS_GLO) {
+        skipbits(rd,3); /* day of week */
+        *t     =rdbitu(rd,27)*0.001;
+    }
+    else if (sys==SYS_CMP) {
+        *t     =rdbitu(rd,30)*0.001;
+        *t+=14.0; /* BDT -> GPST */
+    }
+    else {
+        *t     =rdbitu(rd,30)*0.001;
+    }
+    head->sync =rdbitu(rd, 1);
+    *iod       =rdbitu(rd, 3);
+    h->time_s  =rdbitu(rd, 7);
+    h->clk_str =rdbitu(rd, 2);
+    h->clk_ext =rdbitu(rd, 2);
+    h->smooth  =rdbitu(rd, 1);
+    h->tint_s  =rdbitu(rd, 3);
+    for (i=0;i<2;i++) { /* satellite mask by 32-bit words */
+        mask=rdbitu(rd,32);
         for (j=1;j<=32;j++) {
-            mask=getbitu(rtcm->buff,i,1); i+=1;
-            if (mask) h->sigs[h->nsig++]=j;
+            if (mask>>(32-j)&1) h->sats[h->nsat++]=i*32+j;
         }
     }
-    else {
+    h->sigmask=rdbitu(rd,32);
+    for (j=1;j<=32;j++) {
+        if (h->sigmask>>(32-j)&1) h->sigs[h->nsig++]=j;
+    }
+    head->nsat=h->nsat;
+    return h->nsat;
+}
+/* decode type MSM message header --------------------------------------------*/
+static int decode_msm_head(rtcm_t *rtcm, int sys, int *sync, int *iod,
+                           msm_h_t *h, bitrd_t *rd)
+{
+    rtcm_head_t head={0};
+    double t;
+    char *msg,tstr[64];
+    uint32_t mask;
+    int i,j,n,staid,type,ncell=0;
+
+    type=getbitu(rtcm->pbuff,24,12);
+    init_bitrd(rd,rtcm->pbuff,rtcm->len,24+12);
+
+    if (peek_msm_head(rd,sys,&head,&t,iod,h)<0) {
         trace(2,"rtcm3 %d length error: len=%d\n",type,rtcm->len);
         return -1;
     }
+    if (sys==SYS_GLO) adjday_glot(rtcm,t);
+    else adjweek(rtcm,t);
+    staid=head.staid;
+    *sync=head.sync;
+
     /* test station id */
     if (!test_staid(rtcm,staid)) return -1;
 
@@ -2154,16 +2460,19 @@ static int decode_msm_head(rtcm_t *rtcm, int sys, int *sync, int *iod,
               type,h->nsat,h->nsig);
         return -1;
     }
-    if (i+h->nsat*h->nsig>rtcm->len*8) {
+    if (bitrd_left(rd)<h->nsat*h->nsig) {
         trace(2,"rtcm3 %d length error: len=%d nsat=%d nsig=%d\n",type,
               rtcm->len,h->nsat,h->nsig);
         return -1;
     }
-    for (j=0;j<h->nsat*h->nsig;j++) {
-        h->cellmask[j]=getbitu(rtcm->buff,i,1); i+=1;
-        if (h->cellmask[j]) ncell++;
+    for (j=0;j<h->nsat*h->nsig;j+=n) { /* cell mask by up to 32 bits */
+        n=h->nsat*h->nsig-j<32?h->nsat*h->nsig-j:32;
+        mask=rdbitu(rd,n);
+        for (i=0;i<n;i++) {
+            h->cellmask[j+i]=(uint8_t)(mask>>(n-1-i)&1);
+            ncell+=h->cellmask[j+i];
+        }
     }
-    *hsize=i;
 
     time2str(rtcm->time,tstr,2);
     trace(4,"decode_head_msm: time=%s sys=%d staid=%d nsat=%d nsig=%d sync=%d iod=%d ncell=%d\n",
@@ -2179,61 +2488,44 @@ static int decode_msm_head(rtcm_t *rtcm, int sys, int *sync, int *iod,
 /* decode unsupported MSM message --------------------------------------------*/
 static int decode_msm0(rtcm_t *rtcm, int sys)
 {
+    bitrd_t rd;
     msm_h_t h={0};
-    int i,sync,iod;
-    if (decode_msm_head(rtcm,sys,&sync,&iod,&h,&i)<0) return -1;
+    int sync,iod;
+    if (decode_msm_head(rtcm,sys,&sync,&iod,&h,&rd)<0) return -1;
     rtcm->obsflag=!sync;
     return sync?0:1;
 }
 /* decode MSM 4: full pseudorange and phaserange plus CNR --------------------*/
 static int decode_msm4(rtcm_t *rtcm, int sys)
 {
+    bitrd_t rd;
     msm_h_t h={0};
-    double r[64],pr[64],cp[64],cnr[64];
-    int i,j,type,sync,iod,ncell,rng,rng_m,prv,cpv,lock[64],half[64];
+    msm_d_t d;
+    int type,sync,iod,ncell;
 
-    type=getbitu(rtcm->buff,24,12);
+    type=getbitu(rtcm->pbuff,24,12);
 
     /* decode msm header */
-    if ((ncell=decode_msm_head(rtcm,sys,&sync,&iod,&h,&i))<0) return -1;
+    if ((ncell=decode_msm_head(rtcm,sys,&sync,&iod,&h,&rd))<0) return -1;
 
-    if (i+h.nsat*18+ncell*48>rtcm->len*8) {
+    if (bitrd_left(&rd)<h.nsat*18+ncell*48) {
         trace(2,"rtcm3 %d length error: nsat=%d ncell=%d len=%d\n",type,h.nsat,
               ncell,rtcm->len);
         return -1;
     }
-    for (j=0;j<h.nsat;j++) r[j]=0.0;
-    for (j=0;j<ncell;j++) pr[j]=cp[j]=-1E16;
-
     /* decode satellite data */
-    for (j=0;j<h.nsat;j++) { /* range */
-        rng  =getbitu(rtcm->buff,i, 8); i+= 8;
-        if (rng!=255) r[j]=rng*RANGE_MS;
-    }
-    for (j=0;j<h.nsat;j++) {
-        rng_m=getbitu(rtcm->buff,i,10); i+=10;
-        if (r[j]!=0.0) r[j]+=rng_m*P2_10*RANGE_MS;
-    }
+    rdcells(&rd, 8,0,h.nsat,d.rng  ); /* range */
+    rdcells(&rd,10,0,h.nsat,d.rng_m);
+
     /* decode signal data */
-    for (j=0;j<ncell;j++) { /* pseudorange */
-        prv=getbits(rtcm->buff,i,15); i+=15;
-        if (prv!=-16384) pr[j]=prv*P2_24*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* phaserange */
-        cpv=getbits(rtcm->buff,i,22); i+=22;
-        if (cpv!=-2097152) cp[j]=cpv*P2_29*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* lock time */
-        lock[j]=getbitu(rtcm->buff,i,4); i+=4;
-    }
-    for (j=0;j<ncell;j++) { /* half-cycle ambiguity */
-        half[j]=getbitu(rtcm->buff,i,1); i+=1;
-    }
-    for (j=0;j<ncell;j++) { /* cnr */
-        cnr[j]=getbitu(rtcm->buff,i,6)*1.0; i+=6;
-    }
+    rdcells(&rd,15,1,ncell,d.pr  ); /* pseudorange */
+    rdcells(&rd,22,1,ncell,d.cp  ); /* phaserange */
+    rdcells(&rd, 4,0,ncell,d.lock); /* lock time */
+    rdcells(&rd, 1,0,ncell,d.half); /* half-cycle ambiguity */
+    rdcells(&rd, 6,0,ncell,d.cnr ); /* cnr */
+
     /* save obs data in msm message */
-    save_msm_obs(rtcm,sys,&h,r,pr,cp,NULL,NULL,cnr,lock,NULL,half);
+    save_msm_obs(rtcm,sys,4,&h,&d);
 
     rtcm->obsflag=!sync;
     return sync?0:1;
@@ -2241,66 +2533,37 @@ static int decode_msm4(rtcm_t *rtcm, int sys)
 /* decode MSM 5: full pseudorange, phaserange, phaserangerate and CNR --------*/
 static int decode_msm5(rtcm_t *rtcm, int sys)
 {
+    bitrd_t rd;
     msm_h_t h={0};
-    double r[64],rr[64],pr[64],cp[64],rrf[64],cnr[64];
-    int i,j,type,sync,iod,ncell,rng,rng_m,rate,prv,cpv,rrv,lock[64];
-    int ex[64],half[64];
+    msm_d_t d;
+    int type,sync,iod,ncell;
 
-    type=getbitu(rtcm->buff,24,12);
+    type=getbitu(rtcm->pbuff,24,12);
 
     /* decode msm header */
-    if ((ncell=decode_msm_head(rtcm,sys,&sync,&iod,&h,&i))<0) return -1;
+    if ((ncell=decode_msm_head(rtcm,sys,&sync,&iod,&h,&rd))<0) return -1;
 
-    if (i+h.nsat*36+ncell*63>rtcm->len*8) {
+    if (bitrd_left(&rd)<h.nsat*36+ncell*63) {
         trace(2,"rtcm3 %d length error: nsat=%d ncell=%d len=%d\n",type,h.nsat,
               ncell,rtcm->len);
         return -1;
     }
-    for (j=0;j<h.nsat;j++) {
-        r[j]=rr[j]=0.0; ex[j]=15;
-    }
-    for (j=0;j<ncell;j++) pr[j]=cp[j]=rrf[j]=-1E16;
-
     /* decode satellite data */
-    for (j=0;j<h.nsat;j++) { /* range */
-        rng  =getbitu(rtcm->buff,i, 8); i+= 8;
-        if (rng!=255) r[j]=rng*RANGE_MS;
-    }
-    for (j=0;j<h.nsat;j++) { /* extended info */
-        ex[j]=getbitu(rtcm->buff,i, 4); i+= 4;
-    }
-    for (j=0;j<h.nsat;j++) {
-        rng_m=getbitu(rtcm->buff,i,10); i+=10;
-        if (r[j]!=0.0) r[j]+=rng_m*P2_10*RANGE_MS;
-    }
-    for (j=0;j<h.nsat;j++) { /* phaserangerate */
-        rate =getbits(rtcm->buff,i,14); i+=14;
-        if (rate!=-8192) rr[j]=rate*1.0;
-    }
+    rdcells(&rd, 8,0,h.nsat,d.rng  ); /* range */
+    rdcells(&rd, 4,0,h.nsat,d.ex   ); /* extended info */
+    rdcells(&rd,10,0,h.nsat,d.rng_m);
+    rdcells(&rd,14,1,h.nsat,d.rate ); /* phaserangerate */
+
     /* decode signal data */
-    for (j=0;j<ncell;j++) { /* pseudorange */
-        prv=getbits(rtcm->buff,i,15); i+=15;
-        if (prv!=-16384) pr[j]=prv*P2_24*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* phaserange */
-        cpv=getbits(rtcm->buff,i,22); i+=22;
-        if (cpv!=-2097152) cp[j]=cpv*P2_29*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* lock time */
-        lock[j]=getbitu(rtcm->buff,i,4); i+=4;
-    }
-    for (j=0;j<ncell;j++) { /* half-cycle ambiguity */
-        half[j]=getbitu(rtcm->buff,i,1); i+=1;
-    }
-    for (j=0;j<ncell;j++) { /* cnr */
-        cnr[j]=getbitu(rtcm->buff,i,6)*1.0; i+=6;
-    }
-    for (j=0;j<ncell;j++) { /* phaserangerate */
-        rrv=getbits(rtcm->buff,i,15); i+=15;
-        if (rrv!=-16384) rrf[j]=rrv*0.0001;
-    }
+    rdcells(&rd,15,1,ncell,d.pr  ); /* pseudorange */
+    rdcells(&rd,22,1,ncell,d.cp  ); /* phaserange */
+    rdcells(&rd, 4,0,ncell,d.lock); /* lock time */
+    rdcells(&rd, 1,0,ncell,d.half); /* half-cycle ambiguity */
+    rdcells(&rd, 6,0,ncell,d.cnr ); /* cnr */
+    rdcells(&rd,15,1,ncell,d.rrf ); /* phaserangerate */
+
     /* save obs data in msm message */
-    save_msm_obs(rtcm,sys,&h,r,pr,cp,rr,rrf,cnr,lock,ex,half);
+    save_msm_obs(rtcm,sys,5,&h,&d);
 
     rtcm->obsflag=!sync;
     return sync?0:1;
@@ -2308,52 +2571,34 @@ static int decode_msm5(rtcm_t *rtcm, int sys)
 /* decode MSM 6: full pseudorange and phaserange plus CNR (high-res) ---------*/
 static int decode_msm6(rtcm_t *rtcm, int sys)
 {
+    bitrd_t rd;
     msm_h_t h={0};
-    double r[64],pr[64],cp[64],cnr[64];
-    int i,j,type,sync,iod,ncell,rng,rng_m,prv,cpv,lock[64],half[64];
+    msm_d_t d;
+    int type,sync,iod,ncell;
 
-    type=getbitu(rtcm->buff,24,12);
+    type=getbitu(rtcm->pbuff,24,12);
 
     /* decode msm header */
-    if ((ncell=decode_msm_head(rtcm,sys,&sync,&iod,&h,&i))<0) return -1;
+    if ((ncell=decode_msm_head(rtcm,sys,&sync,&iod,&h,&rd))<0) return -1;
 
-    if (i+h.nsat*18+ncell*65>rtcm->len*8) {
+    if (bitrd_left(&rd)<h.nsat*18+ncell*65) {
         trace(2,"rtcm3 %d length error: nsat=%d ncell=%d len=%d\n",type,h.nsat,
               ncell,rtcm->len);
         return -1;
     }
-    for (j=0;j<h.nsat;j++) r[j]=0.0;
-    for (j=0;j<ncell;j++) pr[j]=cp[j]=-1E16;
-
     /* decode satellite data */
-    for (j=0;j<h.nsat;j++) { /* range */
-        rng  =getbitu(rtcm->buff,i, 8); i+= 8;
-        if (rng!=255) r[j]=rng*RANGE_MS;
-    }
-    for (j=0;j<h.nsat;j++) {
-        rng_m=getbitu(rtcm->buff,i,10); i+=10;
-        if (r[j]!=0.0) r[j]+=rng_m*P2_10*RANGE_MS;
-    }
+    rdcells(&rd, 8,0,h.nsat,d.rng  ); /* range */
+    rdcells(&rd,10,0,h.nsat,d.rng_m);
+
     /* decode signal data */
-    for (j=0;j<ncell;j++) { /* pseudorange */
-        prv=getbits(rtcm->buff,i,20); i+=20;
-        if (prv!=-524288) pr[j]=prv*P2_29*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* phaserange */
-        cpv=getbits(rtcm->buff,i,24); i+=24;
-        if (cpv!=-8388608) cp[j]=cpv*P2_31*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* lock time */
-        lock[j]=getbitu(rtcm->buff,i,10); i+=10;
-    }
-    for (j=0;j<ncell;j++) { /* half-cycle ambiguity */
-        half[j]=getbitu(rtcm->buff,i,1); i+=1;
-    }
-    for (j=0;j<ncell;j++) { /* cnr */
-        cnr[j]=getbitu(rtcm->buff,i,10)*0.0625; i+=10;
-    }
+    rdcells(&rd,20,1,ncell,d.pr  ); /* pseudorange */
+    rdcells(&rd,24,1,ncell,d.cp  ); /* phaserange */
+    rdcells(&rd,10,0,ncell,d.lock); /* lock time */
+    rdcells(&rd, 1,0,ncell,d.half); /* half-cycle ambiguity */
+    rdcells(&rd,10,0,ncell,d.cnr ); /* cnr */
+
     /* save obs data in msm message */
-    save_msm_obs(rtcm,sys,&h,r,pr,cp,NULL,NULL,cnr,lock,NULL,half);
+    save_msm_obs(rtcm,sys,6,&h,&d);
 
     rtcm->obsflag=!sync;
     return sync?0:1;
@@ -2361,66 +2606,37 @@ static int decode_msm6(rtcm_t *rtcm, int sys)
 /* decode MSM 7: full pseudorange, phaserange, phaserangerate and CNR (h-res) */
 static int decode_msm7(rtcm_t *rtcm, int sys)
 {
+    bitrd_t rd;
     msm_h_t h={0};
-    double r[64],rr[64],pr[64],cp[64],rrf[64],cnr[64];
-    int i,j,type,sync,iod,ncell,rng,rng_m,rate,prv,cpv,rrv,lock[64];
-    int ex[64],half[64];
+    msm_d_t d;
+    int type,sync,iod,ncell;
 
-    type=getbitu(rtcm->buff,24,12);
+    type=getbitu(rtcm->pbuff,24,12);
 
     /* decode msm header */
-    if ((ncell=decode_msm_head(rtcm,sys,&sync,&iod,&h,&i))<0) return -1;
+    if ((ncell=decode_msm_head(rtcm,sys,&sync,&iod,&h,&rd))<0) return -1;
 
-    if (i+h.nsat*36+ncell*80>rtcm->len*8) {
+    if (bitrd_left(&rd)<h.nsat*36+ncell*80) {
         trace(2,"rtcm3 %d length error: nsat=%d ncell=%d len=%d\n",type,h.nsat,
               ncell,rtcm->len);
         return -1;
     }
-    for (j=0;j<h.nsat;j++) {
-        r[j]=rr[j]=0.0; ex[j]=15;
-    }
-    for (j=0;j<ncell;j++) pr[j]=cp[j]=rrf[j]=-1E16;
-
     /* decode satellite data */
-    for (j=0;j<h.nsat;j++) { /* range */
-        rng  =getbitu(rtcm->buff,i, 8); i+= 8;
-        if (rng!=255) r[j]=rng*RANGE_MS;
-    }
-    for (j=0;j<h.nsat;j++) { /* extended info */
-        ex[j]=getbitu(rtcm->buff,i, 4); i+= 4;
-    }
-    for (j=0;j<h.nsat;j++) {
-        rng_m=getbitu(rtcm->buff,i,10); i+=10;
-        if (r[j]!=0.0) r[j]+=rng_m*P2_10*RANGE_MS;
-    }
-    for (j=0;j<h.nsat;j++) { /* phaserangerate */
-        rate =getbits(rtcm->buff,i,14); i+=14;
-        if (rate!=-8192) rr[j]=rate*1.0;
-    }
+    rdcells(&rd, 8,0,h.nsat,d.rng  ); /* range */
+    rdcells(&rd, 4,0,h.nsat,d.ex   ); /* extended info */
+    rdcells(&rd,10,0,h.nsat,d.rng_m);
+    rdcells(&rd,14,1,h.nsat,d.rate ); /* phaserangerate */
+
     /* decode signal data */
-    for (j=0;j<ncell;j++) { /* pseudorange */
-        prv=getbits(rtcm->buff,i,20); i+=20;
-        if (prv!=-524288) pr[j]=prv*P2_29*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* phaserange */
-        cpv=getbits(rtcm->buff,i,24); i+=24;
-        if (cpv!=-8388608) cp[j]=cpv*P2_31*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* lock time */
-        lock[j]=getbitu(rtcm->buff,i,10); i+=10;
-    }
-    for (j=0;j<ncell;j++) { /* half-cycle amiguity */
-        half[j]=getbitu(rtcm->buff,i,1); i+=1;
-    }
-    for (j=0;j<ncell;j++) { /* cnr */
-        cnr[j]=getbitu(rtcm->buff,i,10)*0.0625; i+=10;
-    }
-    for (j=0;j<ncell;j++) { /* phaserangerate */
-        rrv=getbits(rtcm->buff,i,15); i+=15;
-        if (rrv!=-16384) rrf[j]=rrv*0.0001;
-    }
+    rdcells(&rd,20,1,ncell,d.pr  ); /* pseudorange */
+    rdcells(&rd,24,1,ncell,d.cp  ); /* phaserange */
+    rdcells(&rd,10,0,ncell,d.lock); /* lock time */
+    rdcells(&rd, 1,0,ncell,d.half); /* half-cycle amiguity */
+    rdcells(&rd,10,0,ncell,d.cnr ); /* cnr */
+    rdcells(&rd,15,1,ncell,d.rrf ); /* phaserangerate */
+
     /* save obs data in msm message */
-    save_msm_obs(rtcm,sys,&h,r,pr,cp,rr,rrf,cnr,lock,ex,half);
+    save_msm_obs(rtcm,sys,7,&h,&d);
 
     rtcm->obsflag=!sync;
     return sync?0:1;
@@ -2430,13 +2646,9 @@ static int decode_type1230(rtcm_t *rtcm)
 {
     int i=24+12,j,staid,align,mask,bias;
 
-    if (i+20>=rtcm->len*8) {
-        trace(2,"rtcm3 1230: length error len=%d\n",rtcm->len);
-        return -1;
-    }
-    staid=getbitu(rtcm->buff,i,12); i+=12;
-    align=getbitu(rtcm->buff,i, 1); i+= 1+3;
-    mask =getbitu(rtcm->buff,i, 4); i+= 4;
+    staid=getbitu(rtcm->pbuff,i,12); i+=12;
+    align=getbitu(rtcm->pbuff,i, 1); i+= 1+3;
+    mask =getbitu(rtcm->pbuff,i, 4); i+= 4;
 
     if (rtcm->outtype) {
         sprintf(rtcm->msgtype+strlen(rtcm->msgtype),
@@ -2451,7 +2663,7 @@ static int decode_type1230(rtcm_t *rtcm)
     }
     for (j=0;j<4&&i+16<=rtcm->len*8;j++) {
         if (!(mask&(1<<(3-j)))) continue;
-        bias=getbits(rtcm->buff,i,16); i+=16;
+        bias=getbits(rtcm->pbuff,i,16); i+=16;
         if (bias!=-32768) {
             rtcm->sta.glo_cp_bias[j]=bias*0.02;
         }
@@ -2463,7 +2675,7 @@ static int decode_type4073(rtcm_t *rtcm)
 {
     int i=24+12,subtype;
 
-    subtype=getbitu(rtcm->buff,i,4); i+=4;
+    subtype=getbitu(rtcm->pbuff,i,4); i+=4;
 
     if (rtcm->outtype) {
         sprintf(rtcm->msgtype+strlen(rtcm->msgtype)," subtype=%d",subtype);
@@ -2476,12 +2688,8 @@ static int decode_type4076(rtcm_t *rtcm)
 {
     int i=24+12,ver,subtype;
 
-    if (i+3+8>=rtcm->len*8) {
-        trace(2,"rtcm3 4076: length error len=%d\n",rtcm->len);
-        return -1;
-    }
-    ver    =getbitu(rtcm->buff,i,3); i+=3;
-    subtype=getbitu(rtcm->buff,i,8); i+=8;
+    ver    =getbitu(rtcm->pbuff,i,3); i+=3;
+    subtype=getbitu(rtcm->pbuff,i,8); i+=8;
 
     if (rtcm->outtype) {
         sprintf(rtcm->msgtype+strlen(rtcm->msgtype)," ver=%d subtype=%3d",ver,
@@ -2534,14 +2742,180 @@ static int decode_type4076(rtcm_t *rtcm)
     trace(2,"rtcm3 4076: unsupported message subtype=%d\n",subtype);
     return 0;
 }
+/* message type descriptor (message class MSGF_??? in rtcm.h) ----------------*/
+#define MSGF_OFN    (MSGF_OBS|MSGF_FCN) /* observation with GLONASS fcn */
+
+/* message type index (1-299:1001-1299,300-329:4070-4099,330-429:0-99,0:other)
+* a chain of range compares, so the dispatch is the compares and one indexed
+* load of the descriptor */
+#define MSGIDX(t) ((t)<100?(t)+330:(t)<1001?0:(t)<=1299?(t)-1000:\
+                   (t)<4070?0:(t)<=4099?(t)-3770:0)
+
+#define MT(t,f,s,fl,n1,n2) [MSGIDX(t)]={f,NULL,NULL,s,fl,n1,n2}
+#define MS(t,f,s,fl,n1,n2) [MSGIDX(t)]={NULL,f,NULL,s,fl,n1,n2}
+#define MR(t,f,s,fl,n1,n2) [MSGIDX(t)]={NULL,NULL,f,s,fl,n1,n2}
+
+typedef struct {                /* message type descriptor */
+    int (*dec)(rtcm_t *);       /* decoder of message type */
+    int (*decsys)(rtcm_t *, int); /* decoder by navigation system */
+    int (*decssr)(rtcm_t *, int, int); /* ssr decoder by system and subtype */
+    uint8_t sys;                /* navigation system of decoder */
+    uint8_t flag;               /* message class (MSGF_???) */
+    uint16_t min,max;           /* min and max message length (bytes without
+                                   header and parity) (max=0:unsupported) */
+} msgdesc_t;
+
+/* message type descriptors by message type index (MSGIDX()) -----------------*/
+static const msgdesc_t msg_rtcm3[MAXMSG3]={
+    MR(  11,decode_ssr7    ,SYS_GPS,MSGF_SSR,  9,1023), /* tentative */
+    MR(  12,decode_ssr7    ,SYS_GAL,MSGF_SSR,  9,1023), /* tentative */
+    MR(  13,decode_ssr7    ,SYS_QZS,MSGF_SSR,  9,1023), /* tentative */
+    MR(  14,decode_ssr7    ,SYS_CMP,MSGF_SSR,  9,1023), /* tentative */
+    MT(  63,decode_type1042,0      ,MSGF_EPH, 64,  64), /* RTCM draft */
+    MT(1001,decode_type1001,0      ,MSGF_OBS,  8,1023), /* not supported */
+    MT(1002,decode_type1002,0      ,MSGF_OBS,  8,1023),
+    MT(1003,decode_type1003,0      ,MSGF_OBS,  8,1023), /* not supported */
+    MT(1004,decode_type1004,0      ,MSGF_OBS,  8,1023),
+    MT(1005,decode_type1005,0      ,MSGF_STA, 19,  19),
+    MT(1006,decode_type1006,0      ,MSGF_STA, 21,  21),
+    MT(1007,decode_type1007,0      ,MSGF_STA,  5, 260),
+    MT(1008,decode_type1008,0      ,MSGF_STA,  6, 516),
+    MT(1009,decode_type1009,0      ,MSGF_OBS,  8,1023), /* not supported */
+    MT(1010,decode_type1010,0      ,MSGF_OFN,  8,1023),
+    MT(1011,decode_type1011,0      ,MSGF_OBS,  8,1023), /* not supported */
+    MT(1012,decode_type1012,0      ,MSGF_OFN,  8,1023),
+    MT(1013,decode_type1013,0      ,0       ,  2,1023), /* not supported */
+    MT(1019,decode_type1019,0      ,MSGF_EPH, 61,  61),
+    MT(1020,decode_type1020,0      ,MSGF_EPH, 45,  45),
+    MT(1021,decode_type1021,0      ,0       ,  2,1023), /* not supported */
+    MT(1022,decode_type1022,0      ,0       ,  2,1023), /* not supported */
+    MT(1023,decode_type1023,0      ,0       ,  2,1023), /* not supported */
+    MT(1024,decode_type1024,0      ,0       ,  2,1023), /* not supported */
+    MT(1025,decode_type1025,0      ,0       ,  2,1023), /* not supported */
+    MT(1026,decode_type1026,0      ,0       ,  2,1023), /* not supported */
+    MT(1027,decode_type1027,0      ,0       ,  2,1023), /* not supported */
+    MT(1029,decode_type1029,0      ,MSGF_STA,  9, 264),
+    MT(1030,decode_type1030,0      ,0       ,  2,1023), /* not supported */
+    MT(1031,decode_type1031,0      ,0       ,  2,1023), /* not supported */
+    MT(1032,decode_type1032,0      ,0       ,  2,1023), /* not supported */
+    MT(1033,decode_type1033,0      ,MSGF_STA,  9,1023),
+    MT(1034,decode_type1034,0      ,0       ,  2,1023), /* not supported */
+    MT(1035,decode_type1035,0      ,0       ,  2,1023), /* not supported */
+    MT(1037,decode_type1037,0      ,0       ,  2,1023), /* not supported */
+    MT(1038,decode_type1038,0      ,0       ,  2,1023), /* not supported */
+    MT(1039,decode_type1039,0      ,0       ,  2,1023), /* not supported */
+    MT(1041,decode_type1041,0      ,MSGF_EPH, 61,  61),
+    MT(1042,decode_type1042,0      ,MSGF_EPH, 64,  64),
+    MT(1044,decode_type1044,0      ,MSGF_EPH, 61,  61),
+    MT(1045,decode_type1045,0      ,MSGF_EPH, 62,  62),
+    MT(1046,decode_type1046,0      ,MSGF_EPH, 63,  63),
+    MR(1057,decode_ssr1    ,SYS_GPS,MSGF_SSR,  8,1023),
+    MR(1058,decode_ssr2    ,SYS_GPS,MSGF_SSR,  8,1023),
+    MR(1059,decode_ssr3    ,SYS_GPS,MSGF_SSR,  8,1023),
+    MR(1060,decode_ssr4    ,SYS_GPS,MSGF_SSR,  8,1023),
+    MR(1061,decode_ssr5    ,SYS_GPS,MSGF_SSR,  8,1023),
+    MR(1062,decode_ssr6    ,SYS_GPS,MSGF_SSR,  8,1023),
+    MR(1063,decode_ssr1    ,SYS_GLO,MSGF_SSR,  8,1023),
+    MR(1064,decode_ssr2    ,SYS_GLO,MSGF_SSR,  8,1023),
+    MR(1065,decode_ssr3    ,SYS_GLO,MSGF_SSR,  8,1023),
+    MR(1066,decode_ssr4    ,SYS_GLO,MSGF_SSR,  8,1023),
+    MR(1067,decode_ssr5    ,SYS_GLO,MSGF_SSR,  8,1023),
+    MR(1068,decode_ssr6    ,SYS_GLO,MSGF_SSR,  8,1023),
+    MS(1071,decode_msm0    ,SYS_GPS,MSGF_OBS, 22,1023), /* not supported */
+    MS(1072,decode_msm0    ,SYS_GPS,MSGF_OBS, 22,1023), /* not supported */
+    MS(1073,decode_msm0    ,SYS_GPS,MSGF_OBS, 22,1023), /* not supported */
+    MS(1074,decode_msm4    ,SYS_GPS,MSGF_OBS, 22,1023),
+    MS(1075,decode_msm5    ,SYS_GPS,MSGF_OBS, 22,1023),
+    MS(1076,decode_msm6    ,SYS_GPS,MSGF_OBS, 22,1023),
+    MS(1077,decode_msm7    ,SYS_GPS,MSGF_OBS, 22,1023),
+    MS(1081,decode_msm0    ,SYS_GLO,MSGF_OBS, 22,1023), /* not supported */
+    MS(1082,decode_msm0    ,SYS_GLO,MSGF_OBS, 22,1023), /* not supported */
+    MS(1083,decode_msm0    ,SYS_GLO,MSGF_OBS, 22,1023), /* not supported */
+    MS(1084,decode_msm4    ,SYS_GLO,MSGF_OBS, 22,1023),
+    MS(1085,decode_msm5    ,SYS_GLO,MSGF_OFN, 22,1023),
+    MS(1086,decode_msm6    ,SYS_GLO,MSGF_OBS, 22,1023),
+    MS(1087,decode_msm7    ,SYS_GLO,MSGF_OFN, 22,1023),
+    MS(1091,decode_msm0    ,SYS_GAL,MSGF_OBS, 22,1023), /* not supported */
+    MS(1092,decode_msm0    ,SYS_GAL,MSGF_OBS, 22,1023), /* not supported */
+    MS(1093,decode_msm0    ,SYS_GAL,MSGF_OBS, 22,1023), /* not supported */
+    MS(1094,decode_msm4    ,SYS_GAL,MSGF_OBS, 22,1023),
+    MS(1095,decode_msm5    ,SYS_GAL,MSGF_OBS, 22,1023),
+    MS(1096,decode_msm6    ,SYS_GAL,MSGF_OBS, 22,1023),
+    MS(1097,decode_msm7    ,SYS_GAL,MSGF_OBS, 22,1023),
+    MS(1101,decode_msm0    ,SYS_SBS,MSGF_OBS, 22,1023), /* not supported */
+    MS(1102,decode_msm0    ,SYS_SBS,MSGF_OBS, 22,1023), /* not supported */
+    MS(1103,decode_msm0    ,SYS_SBS,MSGF_OBS, 22,1023), /* not supported */
+    MS(1104,decode_msm4    ,SYS_SBS,MSGF_OBS, 22,1023),
+    MS(1105,decode_msm5    ,SYS_SBS,MSGF_OBS, 22,1023),
+    MS(1106,decode_msm6    ,SYS_SBS,MSGF_OBS, 22,1023),
+    MS(1107,decode_msm7    ,SYS_SBS,MSGF_OBS, 22,1023),
+    MS(1111,decode_msm0    ,SYS_QZS,MSGF_OBS, 22,1023), /* not supported */
+    MS(1112,decode_msm0    ,SYS_QZS,MSGF_OBS, 22,1023), /* not supported */
+    MS(1113,decode_msm0    ,SYS_QZS,MSGF_OBS, 22,1023), /* not supported */
+    MS(1114,decode_msm4    ,SYS_QZS,MSGF_OBS, 22,1023),
+    MS(1115,decode_msm5    ,SYS_QZS,MSGF_OBS, 22,1023),
+    MS(1116,decode_msm6    ,SYS_QZS,MSGF_OBS, 22,1023),
+    MS(1117,decode_msm7    ,SYS_QZS,MSGF_OBS, 22,1023),
+    MS(1121,decode_msm0    ,SYS_CMP,MSGF_OBS, 22,1023), /* not supported */
+    MS(1122,decode_msm0    ,SYS_CMP,MSGF_OBS, 22,1023), /* not supported */
+    MS(1123,decode_msm0    ,SYS_CMP,MSGF_OBS, 22,1023), /* not supported */
+    MS(1124,decode_msm4    ,SYS_CMP,MSGF_OBS, 22,1023),
+    MS(1125,decode_msm5    ,SYS_CMP,MSGF_OBS, 22,1023),
+    MS(1126,decode_msm6    ,SYS_CMP,MSGF_OBS, 22,1023),
+    MS(1127,decode_msm7    ,SYS_CMP,MSGF_OBS, 22,1023),
+    MS(1131,decode_msm0    ,SYS_IRN,MSGF_OBS, 22,1023), /* not supported */
+    MS(1132,decode_msm0    ,SYS_IRN,MSGF_OBS, 22,1023), /* not supported */
+    MS(1133,decode_msm0    ,SYS_IRN,MSGF_OBS, 22,1023), /* not supported */
+    MS(1134,decode_msm4    ,SYS_IRN,MSGF_OBS, 22,1023),
+    MS(1135,decode_msm5    ,SYS_IRN,MSGF_OBS, 22,1023),
+    MS(1136,decode_msm6    ,SYS_IRN,MSGF_OBS, 22,1023),
+    MS(1137,decode_msm7    ,SYS_IRN,MSGF_OBS, 22,1023),
+    MT(1230,decode_type1230,0      ,MSGF_STA,  5,1023),
+    MR(1240,decode_ssr1    ,SYS_GAL,MSGF_SSR,  8,1023), /* draft */
+    MR(1241,decode_ssr2    ,SYS_GAL,MSGF_SSR,  8,1023), /* draft */
+    MR(1242,decode_ssr3    ,SYS_GAL,MSGF_SSR,  8,1023), /* draft */
+    MR(1243,decode_ssr4    ,SYS_GAL,MSGF_SSR,  8,1023), /* draft */
+    MR(1244,decode_ssr5    ,SYS_GAL,MSGF_SSR,  8,1023), /* draft */
+    MR(1245,decode_ssr6    ,SYS_GAL,MSGF_SSR,  8,1023), /* draft */
+    MR(1246,decode_ssr1    ,SYS_QZS,MSGF_SSR,  8,1023), /* draft */
+    MR(1247,decode_ssr2    ,SYS_QZS,MSGF_SSR,  8,1023), /* draft */
+    MR(1248,decode_ssr3    ,SYS_QZS,MSGF_SSR,  8,1023), /* draft */
+    MR(1249,decode_ssr4    ,SYS_QZS,MSGF_SSR,  8,1023), /* draft */
+    MR(1250,decode_ssr5    ,SYS_QZS,MSGF_SSR,  8,1023), /* draft */
+    MR(1251,decode_ssr6    ,SYS_QZS,MSGF_SSR,  8,1023), /* draft */
+    MR(1252,decode_ssr1    ,SYS_SBS,MSGF_SSR,  8,1023), /* draft */
+    MR(1253,decode_ssr2    ,SYS_SBS,MSGF_SSR,  8,1023), /* draft */
+    MR(1254,decode_ssr3    ,SYS_SBS,MSGF_SSR,  8,1023), /* draft */
+    MR(1255,decode_ssr4    ,SYS_SBS,MSGF_SSR,  8,1023), /* draft */
+    MR(1256,decode_ssr5    ,SYS_SBS,MSGF_SSR,  8,1023), /* draft */
+    MR(1257,decode_ssr6    ,SYS_SBS,MSGF_SSR,  8,1023), /* draft */
+    MR(1258,decode_ssr1    ,SYS_CMP,MSGF_SSR,  8,1023), /* draft */
+    MR(1259,decode_ssr2    ,SYS_CMP,MSGF_SSR,  8,1023), /* draft */
+    MR(1260,decode_ssr3    ,SYS_CMP,MSGF_SSR,  8,1023), /* draft */
+    MR(1261,decode_ssr4    ,SYS_CMP,MSGF_SSR,  8,1023), /* draft */
+    MR(1262,decode_ssr5    ,SYS_CMP,MSGF_SSR,  8,1023), /* draft */
+    MR(1263,decode_ssr6    ,SYS_CMP,MSGF_SSR,  8,1023), /* draft */
+    MT(4073,decode_type4073,0      ,0       ,  2,1023),
+    MT(4076,decode_type4076,0      ,MSGF_SSR,  3,1023)
+};
+#undef MT
+#undef MS
+#undef MR
+
 /* decode RTCM ver.3 message -------------------------------------------------*/
 extern int decode_rtcm3(rtcm_t *rtcm)
 {
+    const msgdesc_t *desc;
     double tow;
-    int ret=0,type=getbitu(rtcm->buff,24,12),week;
+    int ret,type=getbitu(rtcm->pbuff,24,12),len=rtcm->len-3,idx,week;
     rtcm->mtype = type;
     trace(3,"decode_rtcm3: len=%3d type=%d\n",rtcm->len,type);
 
+    /* count only disabled message type */
+    if (!(rtcm->tmask[type>>5]&(1u<<(type&31)))) {
+        rtcm->nmask++;
+        return 0;
+    }
     if (rtcm->outtype) {
         sprintf(rtcm->msgtype,"RTCM %4d (%4d):",type,rtcm->len);
     }
@@ -2550,146 +2924,288 @@ extern int decode_rtcm3(rtcm_t *rtcm)
         tow=time2gpst(utc2gpst(timeget()),&week);
         rtcm->time=gpst2time(week,floor(tow));
     }
-    switch (type) {
-        case 1001: ret=decode_type1001(rtcm); break; /* not supported */
-        case 1002: ret=decode_type1002(rtcm); break;
-        case 1003: ret=decode_type1003(rtcm); break; /* not supported */
-        case 1004: ret=decode_type1004(rtcm); break;
-        case 1005: ret=decode_type1005(rtcm); break;
-        case 1006: ret=decode_type1006(rtcm); break;
-        case 1007: ret=decode_type1007(rtcm); break;
-        case 1008: ret=decode_type1008(rtcm); break;
-        case 1009: ret=decode_type1009(rtcm); break; /* not supported */
-        case 1010: ret=decode_type1010(rtcm); break;
-        case 1011: ret=decode_type1011(rtcm); break; /* not supported */
-        case 1012: ret=decode_type1012(rtcm); break;
-        case 1013: ret=decode_type1013(rtcm); break; /* not supported */
-        case 1019: ret=decode_type1019(rtcm); break;
-        case 1020: ret=decode_type1020(rtcm); break;
-        case 1021: ret=decode_type1021(rtcm); break; /* not supported */
-        case 1022: ret=decode_type1022(rtcm); break; /* not supported */
-        case 1023: ret=decode_type1023(rtcm); break; /* not supported */
-        case 1024: ret=decode_type1024(rtcm); break; /* not supported */
-        case 1025: ret=decode_type1025(rtcm); break; /* not supported */
-        case 1026: ret=decode_type1026(rtcm); break; /* not supported */
-        case 1027: ret=decode_type1027(rtcm); break; /* not supported */
-        case 1029: ret=decode_type1029(rtcm); break;
-        case 1030: ret=decode_type1030(rtcm); break; /* not supported */
-        case 1031: ret=decode_type1031(rtcm); break; /* not supported */
-        case 1032: ret=decode_type1032(rtcm); break; /* not supported */
-        case 1033: ret=decode_type1033(rtcm); break;
-        case 1034: ret=decode_type1034(rtcm); break; /* not supported */
-        case 1035: ret=decode_type1035(rtcm); break; /* not supported */
-        case 1037: ret=decode_type1037(rtcm); break; /* not supported */
-        case 1038: ret=decode_type1038(rtcm); break; /* not supported */
-        case 1039: ret=decode_type1039(rtcm); break; /* not supported */
-        case 1041: ret=decode_type1041(rtcm); break;
-        case 1044: ret=decode_type1044(rtcm); break;
-        case 1045: ret=decode_type1045(rtcm); break;
-        case 1046: ret=decode_type1046(rtcm); break;
-        case   63: ret=decode_type1042(rtcm); break; /* RTCM draft */
-        case 1042: ret=decode_type1042(rtcm); break;
-        case 1057: ret=decode_ssr1(rtcm,SYS_GPS,0); break;
-        case 1058: ret=decode_ssr2(rtcm,SYS_GPS,0); break;
-        case 1059: ret=decode_ssr3(rtcm,SYS_GPS,0); break;
-        case 1060: ret=decode_ssr4(rtcm,SYS_GPS,0); break;
-        case 1061: ret=decode_ssr5(rtcm,SYS_GPS,0); break;
-        case 1062: ret=decode_ssr6(rtcm,SYS_GPS,0); break;
-        case 1063: ret=decode_ssr1(rtcm,SYS_GLO,0); break;
-        case 1064: ret=decode_ssr2(rtcm,SYS_GLO,0); break;
-        case 1065: ret=decode_ssr3(rtcm,SYS_GLO,0); break;
-        case 1066: ret=decode_ssr4(rtcm,SYS_GLO,0); break;
-        case 1067: ret=decode_ssr5(rtcm,SYS_GLO,0); break;
-        case 1068: ret=decode_ssr6(rtcm,SYS_GLO,0); break;
-        case 1071: ret=decode_msm0(rtcm,SYS_GPS); break; /* not supported */
-        case 1072: ret=decode_msm0(rtcm,SYS_GPS); break; /* not supported */
-        case 1073: ret=decode_msm0(rtcm,SYS_GPS); break; /* not supported */
-        case 1074: ret=decode_msm4(rtcm,SYS_GPS); break;
-        case 1075: ret=decode_msm5(rtcm,SYS_GPS); break;
-        case 1076: ret=decode_msm6(rtcm,SYS_GPS); break;
-        case 1077: ret=decode_msm7(rtcm,SYS_GPS); break;
-        case 1081: ret=decode_msm0(rtcm,SYS_GLO); break; /* not supported */
-        case 1082: ret=decode_msm0(rtcm,SYS_GLO); break; /* not supported */
-        case 1083: ret=decode_msm0(rtcm,SYS_GLO); break; /* not supported */
-        case 1084: ret=decode_msm4(rtcm,SYS_GLO); break;
-        case 1085: ret=decode_msm5(rtcm,SYS_GLO); break;
-        case 1086: ret=decode_msm6(rtcm,SYS_GLO); break;
-        case 1087: ret=decode_msm7(rtcm,SYS_GLO); break;
-        case 1091: ret=decode_msm0(rtcm,SYS_GAL); break; /* not supported */
-        case 1092: ret=decode_msm0(rtcm,SYS_GAL); break; /* not supported */
-        case 1093: ret=decode_msm0(rtcm,SYS_GAL); break; /* not supported */
-        case 1094: ret=decode_msm4(rtcm,SYS_GAL); break;
-        case 1095: ret=decode_msm5(rtcm,SYS_GAL); break;
-        case 1096: ret=decode_msm6(rtcm,SYS_GAL); break;
-        case 1097: ret=decode_msm7(rtcm,SYS_GAL); break;
-        case 1101: ret=decode_msm0(rtcm,SYS_SBS); break; /* not supported */
-        case 1102: ret=decode_msm0(rtcm,SYS_SBS); break; /* not supported */
-        case 1103: ret=decode_msm0(rtcm,SYS_SBS); break; /* not supported */
-        case 1104: ret=decode_msm4(rtcm,SYS_SBS); break;
-        case 1105: ret=decode_msm5(rtcm,SYS_SBS); break;
-        case 1106: ret=decode_msm6(rtcm,SYS_SBS); break;
-        case 1107: ret=decode_msm7(rtcm,SYS_SBS); break;
-        case 1111: ret=decode_msm0(rtcm,SYS_QZS); break; /* not supported */
-        case 1112: ret=decode_msm0(rtcm,SYS_QZS); break; /* not supported */
-        case 1113: ret=decode_msm0(rtcm,SYS_QZS); break; /* not supported */
-        case 1114: ret=decode_msm4(rtcm,SYS_QZS); break;
-        case 1115: ret=decode_msm5(rtcm,SYS_QZS); break;
-        case 1116: ret=decode_msm6(rtcm,SYS_QZS); break;
-        case 1117: ret=decode_msm7(rtcm,SYS_QZS); break;
-        case 1121: ret=decode_msm0(rtcm,SYS_CMP); break; /* not supported */
-        case 1122: ret=decode_msm0(rtcm,SYS_CMP); break; /* not supported */
-        case 1123: ret=decode_msm0(rtcm,SYS_CMP); break; /* not supported */
-        case 1124: ret=decode_msm4(rtcm,SYS_CMP); break;
-        case 1125: ret=decode_msm5(rtcm,SYS_CMP); break;
-        case 1126: ret=decode_msm6(rtcm,SYS_CMP); break;
-        case 1127: ret=decode_msm7(rtcm,SYS_CMP); break;
-        case 1131: ret=decode_msm0(rtcm,SYS_IRN); break; /* not supported */
-        case 1132: ret=decode_msm0(rtcm,SYS_IRN); break; /* not supported */
-        case 1133: ret=decode_msm0(rtcm,SYS_IRN); break; /* not supported */
-        case 1134: ret=decode_msm4(rtcm,SYS_IRN); break;
-        case 1135: ret=decode_msm5(rtcm,SYS_IRN); break;
-        case 1136: ret=decode_msm6(rtcm,SYS_IRN); break;
-        case 1137: ret=decode_msm7(rtcm,SYS_IRN); break;
-        case 1230: ret=decode_type1230(rtcm);     break;
-        case 1240: ret=decode_ssr1(rtcm,SYS_GAL,0); break; /* draft */
-        case 1241: ret=decode_ssr2(rtcm,SYS_GAL,0); break; /* draft */
-        case 1242: ret=decode_ssr3(rtcm,SYS_GAL,0); break; /* draft */
-        case 1243: ret=decode_ssr4(rtcm,SYS_GAL,0); break; /* draft */
-        case 1244: ret=decode_ssr5(rtcm,SYS_GAL,0); break; /* draft */
-        case 1245: ret=decode_ssr6(rtcm,SYS_GAL,0); break; /* draft */
-        case 1246: ret=decode_ssr1(rtcm,SYS_QZS,0); break; /* draft */
-        case 1247: ret=decode_ssr2(rtcm,SYS_QZS,0); break; /* draft */
-        case 1248: ret=decode_ssr3(rtcm,SYS_QZS,0); break; /* draft */
-        case 1249: ret=decode_ssr4(rtcm,SYS_QZS,0); break; /* draft */
-        case 1250: ret=decode_ssr5(rtcm,SYS_QZS,0); break; /* draft */
-        case 1251: ret=decode_ssr6(rtcm,SYS_QZS,0); break; /* draft */
-        case 1252: ret=decode_ssr1(rtcm,SYS_SBS,0); break; /* draft */
-        case 1253: ret=decode_ssr2(rtcm,SYS_SBS,0); break; /* draft */
-        case 1254: ret=decode_ssr3(rtcm,SYS_SBS,0); break; /* draft */
-        case 1255: ret=decode_ssr4(rtcm,SYS_SBS,0); break; /* draft */
-        case 1256: ret=decode_ssr5(rtcm,SYS_SBS,0); break; /* draft */
-        case 1257: ret=decode_ssr6(rtcm,SYS_SBS,0); break; /* draft */
-        case 1258: ret=decode_ssr1(rtcm,SYS_CMP,0); break; /* draft */
-        case 1259: ret=decode_ssr2(rtcm,SYS_CMP,0); break; /* draft */
-        case 1260: ret=decode_ssr3(rtcm,SYS_CMP,0); break; /* draft */
-        case 1261: ret=decode_ssr4(rtcm,SYS_CMP,0); break; /* draft */
-        case 1262: ret=decode_ssr5(rtcm,SYS_CMP,0); break; /* draft */
-        case 1263: ret=decode_ssr6(rtcm,SYS_CMP,0); break; /* draft */
-        case   11: ret=decode_ssr7(rtcm,SYS_GPS,0); break; /* tentative */
-        case   12: ret=decode_ssr7(rtcm,SYS_GAL,0); break; /* tentative */
-        case   13: ret=decode_ssr7(rtcm,SYS_QZS,0); break; /* tentative */
-        case   14: ret=decode_ssr7(rtcm,SYS_CMP,0); break; /* tentative */
-        case 4073: ret=decode_type4073(rtcm); break;
-        case 4076: ret=decode_type4076(rtcm); break;
-    }
-    // if (ret>=0) {
-    //     if      (1001<=type&&type<=1299) rtcm->nmsg3[type-1000]++; /*   1-299 */
-    //     else if (4070<=type&&type<=4099) rtcm->nmsg3[type-3770]++; /* 300-329 */
-    //     else rtcm->nmsg3[0]++; /* other */
-    // }
+    desc=msg_rtcm3+(idx=MSGIDX(type));
+
+    /* reject unsupported or implausible length message before decoding */
+    if (len<desc->min||len>desc->max) {
+        if (desc->max) trace(2,"rtcm3 %d length error: len=%d\n",type,rtcm->len);
+        else trace(2,"rtcm3 %d: unsupported message type\n",type);
+        rtcm->nreject++;
+        return desc->max?-1:0;
+    }
+    if      (desc->dec   ) ret=desc->dec(rtcm);
+    else if (desc->decsys) ret=desc->decsys(rtcm,desc->sys);
+    else                   ret=desc->decssr(rtcm,desc->sys,0);
+
+    if (ret>=0) rtcm->nmsg3[idx]++;
     return ret;
 }
+/* test frame header (preamble, reserved bits and plausible length) ----------*/
+static int test_head(const uint8_t *buff)
+{
+    /* message length has to include message type (12 bits) at least */
+    return buff[0]==RTCM3PREAMB&&!(buff[1]&0xFC)&&getbitu(buff,14,10)>=2;
+}
+/* search frame start candidate in buffer ------------------------------------*/
+static size_t sync_frame(const uint8_t *buff, size_t len)
+{
+    const uint8_t *p=buff,*q;
+
+    /* memchr() in standard c libraries scans by SSE2/AVX2 vector instructions */
+    while ((q=(const uint8_t *)memchr(p,RTCM3PREAMB,len-(size_t)(p-buff)))) {
+
+        /* header split at end of buffer is tested after completed */
+        if (len-(size_t)(q-buff)<3||test_head(q)) return (size_t)(q-buff);
+        p=q+1;
+    }
+    return len;
+}
+/* test NMEA sentence start ($ and 5 characters of talker and sentence id) --*/
+static int test_nmea(const uint8_t *buff)
+{
+    int i;
+
+    for (i=1;i<6;i++) {
+        if (!('A'<=buff[i]&&buff[i]<='Z')&&!('0'<=buff[i]&&buff[i]<='9')) {
+            return 0;
+        }
+    }
+    return buff[0]=='$';
+}
+/* length of non-RTCM frame by header (0:not frame start or header split) ----*/
+static int foreign_len(const uint8_t *buff, size_t len)
+{
+    int n;
+
+    switch (buff[0]) {
+        case 0xB5: /* u-blox UBX: sync, class, id, length, payload, checksum */
+            if (len<6||buff[1]!=0x62) return 0;
+            n=8+(buff[4]|buff[5]<<8);
+            break;
+        case 0xAA: /* NovAtel OEM binary: sync, header, message, crc-32 */
+            if (len<10||buff[1]!=0x44||buff[2]!=0x12||buff[3]<10) return 0;
+            n=buff[3]+(buff[8]|buff[9]<<8)+4;
+            break;
+        case '$': /* Septentrio SBF: sync, crc, id, length (with header) */
+            if (len<8||buff[1]!='@') return 0;
+            n=buff[6]|buff[7]<<8;
+            if (n<8||n%4) return 0;
+            break;
+        default:
+            return 0;
+    }
+    return n<=MAXRAWLEN?n:0;
+}
+/* test checksum of non-RTCM frame (UBX, NovAtel or SBF) ---------------------*/
+static int test_foreign(const uint8_t *buff, int n)
+{
+    uint8_t cka=0,ckb=0;
+    int i;
+
+    switch (buff[0]) {
+        case 0xB5: /* UBX: 8-bit fletcher of class to payload */
+            for (i=2;i<n-2;i++) {
+                cka+=buff[i]; ckb+=cka;
+            }
+            return cka==buff[n-2]&&ckb==buff[n-1];
+        case 0xAA: /* NovAtel: crc-32 of header and message */
+            return rtk_crc32(buff,n-4)==((uint32_t)buff[n-4]|
+                   (uint32_t)buff[n-3]<<8|(uint32_t)buff[n-2]<<16|
+                   (uint32_t)buff[n-1]<<24);
+        case '$': /* SBF: crc-16 of id to end of block */
+            return rtk_crc16(buff+4,n-4)==(buff[2]|buff[3]<<8);
+    }
+    return 0;
+}
+/* search frame start candidate in mixed stream --------------------------------
+* search RTCM 3 frame start candidate or start of NMEA sentence, UBX, SBF or
+* NovAtel binary frame. for the other framing, rtcm->flen or rtcm->fline is
+* set to skip it. a RTCM 3 preamble inside the other framing is not searched.
+*-----------------------------------------------------------------------------*/
+static size_t sync_mixed(rtcm_t *rtcm, const uint8_t *buff, size_t len)
+{
+    size_t i;
+    int n;
+
+    for (i=0;i<len;i++) {
+        switch (buff[i]) {
+            case RTCM3PREAMB:
+                if (len-i<3||test_head(buff+i)) return i;
+                break;
+            case '$':
+                if (len-i>=6&&test_nmea(buff+i)) {
+                    rtcm->fline=MAXNMEA;
+                    return i;
+                }
+                /* fall through */
+            case 0xB5: case 0xAA:
+                if ((n=foreign_len(buff+i,len-i))>0) {
+                    rtcm->flen=n;
+                    return i;
+                }
+                break;
+        }
+    }
+    return len;
+}
+/* skip rest of NMEA sentence in mixed stream --------------------------------*/
+static size_t skip_nmea(rtcm_t *rtcm, const uint8_t *buff, size_t len)
+{
+    const uint8_t *q;
+    size_t n;
+
+    n=(size_t)rtcm->fline<len?(size_t)rtcm->fline:len;
+    if ((q=(const uint8_t *)memchr(buff,'\n',n))) {
+        n=(size_t)(q-buff)+1;
+        rtcm->fline=0;
+    }
+    else rtcm->fline-=(int)n;
+    rtcm->nforeign+=(uint32_t)n;
+    return n;
+}
+/* append data to message buffer and update running parity -------------------*/
+static void append_buff(rtcm_t *rtcm, const uint8_t *data, int n)
+{
+    int m;
+
+    if (rtcm->nbyte==0) rtcm->parity=0;
+
+    /* header and message are covered by parity (length known after header) */
+    m=rtcm->nbyte<3?n:rtcm->len-rtcm->nbyte;
+    if (m>n) m=n;
+    if (m>0) rtcm->parity=rtk_crc24q_upd(rtcm->parity,data,m);
+
+    memcpy(rtcm->buff+rtcm->nbyte,data,n);
+    rtcm->nbyte+=n;
+}
+/* discard bytes in message buffer and synchronize to next frame candidate ---*/
+static void shift_buff(rtcm_t *rtcm, int n)
+{
+    int m;
+
+    if (n<rtcm->nbyte) {
+        m=n+(int)sync_frame(rtcm->buff+n,(size_t)(rtcm->nbyte-n));
+        rtcm->nskip+=m-n;
+        memmove(rtcm->buff,rtcm->buff+m,rtcm->nbyte-m);
+        rtcm->nbyte-=m;
+        rtcm->recov=rtcm->recov>m?rtcm->recov-m:0;
+    }
+    else rtcm->nbyte=rtcm->recov=0;
+
+    if (rtcm->nbyte==0) return;
+    /* recompute length and parity of the candidate */
+    m=rtcm->nbyte;
+    if (rtcm->nbyte>=3) {
+        rtcm->len=getbitu(rtcm->buff,14,10)+3; /* length without parity */
+        if (m>rtcm->len) m=rtcm->len;
+    }
+    rtcm->parity=rtk_crc24q(rtcm->buff,m);
+}
+/* input non-RTCM frame in mixed stream ---------------------------------------
+* test checksum of non-RTCM frame and skip it. a frame complete in the buffer is
+* tested in place, and a frame split at the end of buffer is copied to message
+* buffer and tested after completed. after a checksum error, the frame start is
+* taken as false and the following bytes are resynchronized. return number of
+* bytes consumed in the buffer.
+*-----------------------------------------------------------------------------*/
+static size_t input_foreign(rtcm_t *rtcm, const uint8_t *buff, size_t len)
+{
+    size_t n;
+    int m=rtcm->flen;
+
+    if (rtcm->nbyte==0&&(size_t)m<=len) {
+        rtcm->flen=0;
+        if (test_foreign(buff,m)) {
+            rtcm->nforeign+=(uint32_t)m;
+            return (size_t)m;
+        }
+        trace(2,"non-rtcm frame checksum error: len=%d\n",m);
+        rtcm->nskip++;
+        return 1;
+    }
+    n=(size_t)(m-rtcm->nbyte);
+    if (n>len) n=len;
+    memcpy(rtcm->buff+rtcm->nbyte,buff,n);
+    rtcm->nbyte+=(int)n;
+    if (rtcm->nbyte<m) return n;
+
+    rtcm->flen=0;
+    if (test_foreign(rtcm->buff,m)) {
+        rtcm->nforeign+=(uint32_t)m;
+        rtcm->nbyte=0;
+        return n;
+    }
+    trace(2,"non-rtcm frame checksum error: len=%d\n",m);
+
+    /* rescan the bytes after the false frame start for RTCM 3 frame */
+    rtcm->nskip++;
+    if (rtcm->recov<m) rtcm->recov=m;
+    shift_buff(rtcm,1);
+    return n;
+}
+/* decode rtcm3 message in frame (len: length without parity) ----------------*/
+static int test_dup(rtcm_dedup_t *dedup, const uint8_t *frame, int len);
+
+static int decode_frame(rtcm_t *rtcm, const uint8_t *frame, int len)
+{
+    int ret,len0=rtcm->len,type=getbitu(frame,24,12);
+
+    /* count only disabled message type (not registered to duplicate filter) */
+    if (!(rtcm->tmask[type>>5]&(1u<<(type&31)))) {
+        rtcm->nmask++;
+        return 0;
+    }
+    /* drop duplicate frame of redundant stream before decoding */
+    if (rtcm->dedup&&test_dup(rtcm->dedup,frame,len)) return 0;
 
+    /* relay frame without decoding */
+    if (rtcm->relay) {
+        /* frame in message buffer is overwritten by the following input */
+        if (frame==rtcm->buff) {
+            memcpy(rtcm->rbuff,frame,len+3);
+            frame=rtcm->rbuff;
+        }
+        rtcm->rframe=frame;
+        rtcm->rlen=len+3;
+        return 1;
+    }
+    /* message pointer is valid only in decoding */
+    rtcm->pbuff=frame;
+    rtcm->len=len;
+    ret=decode_rtcm3(rtcm);
+    rtcm->pbuff=NULL;
+    rtcm->len=len0;
+    return ret;
+}
+/* check parity and decode complete frame in message buffer ------------------*/
+static int input_frame(rtcm_t *rtcm)
+{
+    int ret;
+
+    if (rtcm->nbyte<3||rtcm->nbyte<rtcm->len+3) return 0;
+
+    /* check parity (computed while appending to buffer) */
+    if (rtcm->parity!=getbitu(rtcm->buff,rtcm->len*8,24)) {
+        trace(2,"rtcm3 parity error: len=%d\n",rtcm->len);
+        // crc error
+        rtcm->crc = 1;
+
+        /* rescan the bytes after the false preamble for next frame */
+        rtcm->nskip++;
+        if (rtcm->recov<rtcm->len+3) rtcm->recov=rtcm->len+3;
+        shift_buff(rtcm,1);
+        return 0;
+    }
+    rtcm->crc = 0;
+    if (rtcm->recov>0) rtcm->nrecov++;
+
+    /* decode rtcm3 message */
+    ret=decode_frame(rtcm,rtcm->buff,rtcm->len);
+
+    /* bytes following the frame are left only by rescan after parity error */
+    shift_buff(rtcm,rtcm->len+3);
+    return ret;
+}
 /* input RTCM 3 message from stream --------------------------------------------
 * fetch next RTCM 3 message and input a message from byte stream
 * args   : rtcm_t *rtcm     IO  rtcm control struct
@@ -2760,35 +3276,613 @@ extern int decode_rtcm3(rtcm_t *rtcm)
 *            +----------+--------+-----------+--------------------+----------+
 *            |<-- 8 --->|<- 6 -->|<-- 10 --->|<--- length x 8 --->|<-- 24 -->|
 *
+*          a preamble followed by non-zero reserved bits or length < 2 is not
+*          taken as frame start in the frame synchronization. after a parity
+*          error, the frame synchronization restarts from the byte following
+*          the false preamble, so a frame inside the bad frame is recovered.
+*
 *-----------------------------------------------------------------------------*/
 int input_rtcm3(rtcm_t *rtcm, uint8_t data)
 {
     trace(5,"input_rtcm3: data=%02x\n",data);
 
     /* synchronize frame */
-    if (rtcm->nbyte==0) {
-        if (data!=RTCM3PREAMB) return 0;
-        rtcm->buff[rtcm->nbyte++]=data;
+    if (rtcm->nbyte==0&&data!=RTCM3PREAMB) {
+        rtcm->nskip++;
         return 0;
     }
-    rtcm->buff[rtcm->nbyte++]=data;
+    append_buff(rtcm,&data,1);
 
     if (rtcm->nbyte==3) {
+        if (!test_head(rtcm->buff)) {
+            rtcm->nskip++;
+            shift_buff(rtcm,1);
+            return 0;
+        }
         rtcm->len=getbitu(rtcm->buff,14,10)+3; /* length without parity */
     }
-    if (rtcm->nbyte<3||rtcm->nbyte<rtcm->len+3) return 0;
-    rtcm->nbyte=0;
+    return input_frame(rtcm);
+}
+/* input RTCM 3 message from buffer --------------------------------------------
+* fetch next RTCM 3 message and input a message from a buffer of byte stream
+* args   : rtcm_t *rtcm     IO  rtcm control struct
+*          uint8_t *buff    I   stream data
+*          size_t len       I   stream data length (bytes)
+*          size_t *consumed O   number of bytes consumed in the buffer
+* return : status (same as input_rtcm3())
+* notes  : the function returns just after a complete frame is input, so call
+*          it again with the rest of the buffer until all the data consumed.
+*          an incomplete frame at the end of buffer is kept in rtcm control
+*          struct and continued by the next call. a complete frame in the
+*          buffer is decoded in place without copy to the message buffer.
+*          after a parity error, the bytes following the false preamble are
+*          rescanned for the next frame. a frame recovered by the rescan may
+*          be left complete in the buffer when the function returns. it is
+*          input by the next call (len=0 is allowed for it).
+*
+*          in mixed stream mode (rtcm->mixed=1), NMEA sentences and UBX, SBF
+*          and NovAtel binary frames starting out of RTCM 3 frame are skipped
+*          by the length in the header or to the end of line without search
+*          of RTCM 3 preamble in them. a header split at the end of buffer is
+*          not recognized. a binary frame is skipped only if the checksum is
+*          correct. otherwise the bytes following the false frame start are
+*          resynchronized (a frame split at the end of buffer is copied to
+*          message buffer and only RTCM 3 frames are rescanned in it).
+*-----------------------------------------------------------------------------*/
+extern int input_rtcm3_buf(rtcm_t *rtcm, const uint8_t *buff, size_t len,
+                           size_t *consumed)
+{
+    size_t i=0,n;
+
+    trace(4,"input_rtcm3_buf: len=%d\n",(int)len);
+
+    for (;;) {
+
+        /* non-RTCM frame in mixed stream (tested by checksum) */
+        if (rtcm->flen>0) {
+            if (i>=len) break;
+            i+=input_foreign(rtcm,buff+i,len-i);
+            continue;
+        }
+        /* complete frame (or frame recovered after parity error) in buffer */
+        if (rtcm->nbyte>=3&&rtcm->nbyte>=rtcm->len+3) {
+            *consumed=i;
+            return input_frame(rtcm);
+        }
+        if (i>=len) break;
+
+        /* synchronize frame */
+        if (rtcm->nbyte==0) {
+            if (rtcm->fline>0) {
+                i+=skip_nmea(rtcm,buff+i,len-i);
+                continue;
+            }
+            n=rtcm->mixed?sync_mixed(rtcm,buff+i,len-i):sync_frame(buff+i,len-i);
+            rtcm->nskip+=(uint32_t)n;
+            if ((i+=n)>=len) break;
+            if (rtcm->flen>0||rtcm->fline>0) continue;
+
+            /* decode complete frame in the buffer without copy */
+            if (len-i>=3&&(n=getbitu(buff+i,14,10)+6)<=len-i&&
+                rtk_crc24q(buff+i,(int)n-3)==getbitu(buff+i,((int)n-3)*8,24)) {
+                *consumed=i+n;
+                rtcm->crc = 0;
+                return decode_frame(rtcm,buff+i,(int)n-3);
+            }
+            /* incomplete frame or parity error (rescanned in buffer) */
+            n=len-i<3?len-i:3;
+            append_buff(rtcm,buff+i,(int)n);
+            i+=n;
+            if (rtcm->nbyte==3) {
+                rtcm->len=getbitu(rtcm->buff,14,10)+3; /* length without parity */
+            }
+            continue;
+        }
+        if (rtcm->nbyte<3) {
+            append_buff(rtcm,buff+i++,1);
+            if (rtcm->nbyte==3) {
+                if (!test_head(rtcm->buff)) {
+                    rtcm->nskip++;
+                    shift_buff(rtcm,1);
+                    continue;
+                }
+                rtcm->len=getbitu(rtcm->buff,14,10)+3; /* length without parity */
+            }
+            continue;
+        }
+        /* copy rest of the frame */
+        n=(size_t)(rtcm->len+3-rtcm->nbyte);
+        if (n>len-i) n=len-i;
+        append_buff(rtcm,buff+i,(int)n);
+        i+=n;
+    }
+    *consumed=i;
+    return 0;
+}
+/* station id in frame header (0:no station id) -----------------------------*/
+static int frame_staid(const uint8_t *frame, int len, int type)
+{
+    if (len<6+3) return 0; /* message type and station id (24 bits) */
+
+    if ((1001<=type&&type<=1012)||(1071<=type&&type<=1137&&1<=type%10&&
+        type%10<=7)) {
+        return getbitu(frame,24+12,12);
+    }
+    switch (type) {
+        case 1005: case 1006: case 1007: case 1008: case 1029: case 1033:
+        case 1230:
+            return getbitu(frame,24+12,12);
+    }
+    return 0;
+}
+/* relay RTCM 3 frames from buffer ---------------------------------------------
+* fetch RTCM 3 frames from a buffer of byte stream without decoding
+* args   : rtcm_t *rtcm     IO  rtcm control struct
+*          uint8_t *buff    I   stream data
+*          size_t len       I   stream data length (bytes)
+*          rtcm_iov_t *iov  O   frames (layout of struct iovec for writev())
+*          rtcm_head_t *head O  frame headers (type and staid) (NULL: no output)
+*          int    nmax      I   max number of frames
+*          size_t *consumed O   number of bytes consumed in the buffer
+* return : number of frames
+* notes  : the frames are synchronized and parity-checked as input_rtcm3_buf()
+*          but not decoded, and obs, nav and the other decoding state in rtcm
+*          control struct are not changed. the frames of message types
+*          disabled by set_rtcm_type() or dropped by the duplicate frame
+*          filter are not output.
+*          a frame in the buffer refers to the buffer. a frame continued from
+*          the previous call refers to rtcm->rbuff valid until the next call,
+*          so the function returns just after the frame. call the function
+*          again with the rest of the buffer until all the data consumed.
+*-----------------------------------------------------------------------------*/
+extern int relay_rtcm3(rtcm_t *rtcm, const uint8_t *buff, size_t len,
+                       rtcm_iov_t *iov, rtcm_head_t *head, int nmax,
+                       size_t *consumed)
+{
+    rtcm_head_t h0={0};
+    size_t i=0,n;
+    int nfrm=0;
+
+    trace(4,"relay_rtcm3: len=%d nmax=%d\n",(int)len,nmax);
+
+    rtcm->relay=1;
 
+    while (nfrm<nmax&&(i<len||(rtcm->flen==0&&rtcm->nbyte>=3&&
+                               rtcm->nbyte>=rtcm->len+3))) {
+        if (input_rtcm3_buf(rtcm,buff+i,len-i,&n)<=0) {
+            i+=n;
+            continue;
+        }
+        i+=n;
+        iov[nfrm].base=rtcm->rframe;
+        iov[nfrm].len=(size_t)rtcm->rlen;
+        if (head) {
+            head[nfrm]=h0;
+            head[nfrm].type=getbitu(rtcm->rframe,24,12);
+            head[nfrm].staid=frame_staid(rtcm->rframe,rtcm->rlen,head[nfrm].type);
+        }
+        nfrm++;
+        if (rtcm->rframe==rtcm->rbuff) break;
+    }
+    rtcm->relay=0;
+    *consumed=i;
+    return nfrm;
+}
+/* decode RTCM 3 frame ---------------------------------------------------------
+* check parity and decode a complete RTCM 3 frame in caller's memory
+* args   : rtcm_t *rtcm     IO  rtcm control struct
+*          uint8_t *frame   I   RTCM 3 frame (preamble to parity)
+*          int    len       I   frame length (bytes)
+* return : status (same as input_rtcm3())
+* notes  : the frame is decoded in place without copy to the message buffer.
+*          a frame partially input by input_rtcm3() or input_rtcm3_buf() is
+*          not affected.
+*-----------------------------------------------------------------------------*/
+extern int decode_rtcm3_frame(rtcm_t *rtcm, const uint8_t *frame, int len)
+{
+    trace(4,"decode_rtcm3_frame: len=%d\n",len);
+
+    if (len<6||!test_head(frame)||(int)getbitu(frame,14,10)+6!=len) {
+        trace(2,"rtcm3 frame length error: len=%d\n",len);
+        return -1;
+    }
     /* check parity */
-    if (rtk_crc24q(rtcm->buff,rtcm->len)!=getbitu(rtcm->buff,rtcm->len*8,24)) {
-        trace(2,"rtcm3 parity error: len=%d\n",rtcm->len);
-        // crc error
+    if (rtk_crc24q(frame,len-3)!=getbitu(frame,(len-3)*8,24)) {
+        trace(2,"rtcm3 parity error: len=%d\n",len-3);
         rtcm->crc = 1;
         return 0;
     }
     rtcm->crc = 0;
-    /* decode rtcm3 message */
-    return decode_rtcm3(rtcm);
+    return decode_frame(rtcm,frame,len-3);
+}
+/* check parity of RTCM 3 frames ----------------------------------------------
+* check crc-24q parities of multiple frames packed in a buffer
+* args   : uint8_t *buff    I   packed frames
+*          size_t *offset   I   frame offsets in buffer (n+1 offsets)
+*                               (frame i: buff[offset[i]]...buff[offset[i+1]-1])
+*          int    n         I   number of frames
+*          uint8_t *valid   O   validity bitmap of frames ((n+7)/8 bytes)
+*                               (frame i: bit i%8 (LSB first) of valid[i/8])
+* return : number of valid frames
+* notes  : the last 3 bytes of each frame are taken as the parity as in
+*          CheckCrc() and a frame shorter than 6 bytes is invalid. the
+*          parities of independent frames are computed by interleaved lanes.
+*-----------------------------------------------------------------------------*/
+extern int check_rtcm3_crc(const uint8_t *buff, const size_t *offset, int n,
+                           uint8_t *valid)
+{
+    const uint8_t *p[64];
+    uint32_t crc[64];
+    int i,j,m,len[64],nvalid=0;
+
+    trace(4,"check_rtcm3_crc: n=%d\n",n);
+
+    memset(valid,0,(size_t)(n+7)/8);
+
+    for (i=0;i<n;i+=m) {
+        m=n-i<64?n-i:64;
+        for (j=0;j<m;j++) {
+            p[j]=buff+offset[i+j];
+            len[j]=(int)(offset[i+j+1]-offset[i+j])-3;
+        }
+        rtk_crc24q_n(p,len,m,crc);
+
+        for (j=0;j<m;j++) {
+            if (len[j]<3||crc[j]!=((uint32_t)p[j][len[j]]<<16|
+                                   (uint32_t)p[j][len[j]+1]<<8|p[j][len[j]+2])) {
+                continue;
+            }
+            valid[(i+j)/8]|=1u<<((i+j)%8);
+            nvalid++;
+        }
+    }
+    return nvalid;
+}
+/* SSR message system and number (ssr: SSR message number 1-7, 0:not SSR) ----*/
+static int ssr_type(const uint8_t *buff, int len, int type, int *sys,
+                    int *subtype)
+{
+    static const int sys_rtcm[]={SYS_GAL,SYS_QZS,SYS_SBS,SYS_CMP};
+    static const int sys_tent[]={SYS_GPS,SYS_GAL,SYS_QZS,SYS_CMP};
+    static const int sys_igs []={SYS_GPS,SYS_GLO,SYS_GAL,SYS_QZS,SYS_CMP,SYS_SBS};
+    static const int ssr_igs []={1,2,4,6,3,7,5};
+    int n;
+
+    *subtype=0;
+    if (1057<=type&&type<=1068) {
+        *sys=type<=1062?SYS_GPS:SYS_GLO;
+        return (type-1057)%6+1;
+    }
+    if (1240<=type&&type<=1263) {
+        *sys=sys_rtcm[(type-1240)/6];
+        return (type-1240)%6+1;
+    }
+    if (11<=type&&type<=14) { /* tentative */
+        *sys=sys_tent[type-11];
+        return 7;
+    }
+    if (type==4076&&24+12+3+8<=len*8) {
+        *subtype=getbitu(buff,24+12+3,8);
+        if ((n=*subtype/20)<1||n>6||*subtype%20<1||*subtype%20>7) return 0;
+        *sys=sys_igs[n-1];
+        return ssr_igs[*subtype%20-1];
+    }
+    return 0;
+}
+/* peek message header and epoch time (t: GPST tow or GLONASS tod) -----------*/
+static int peek_epoch(const uint8_t *frame, int len, rtcm_head_t *head,
+                      double *t)
+{
+    rtcm_head_t h0={0};
+    msm_h_t h;
+    bitrd_t rd;
+    int ret,type,sys,subtype,ssr,iod,glo=0;
+
+    *head=h0;
+    if (len<6||!test_head(frame)||(int)getbitu(frame,14,10)+6!=len) {
+        trace(2,"rtcm3 frame length error: len=%d\n",len);
+        return -1;
+    }
+    len-=3; /* message length without parity */
+    type=head->type=getbitu(frame,24,12);
+
+    if (1001<=type&&type<=1004) {
+        ret=peek_head1001(frame,len,head,t);
+    }
+    else if (1009<=type&&type<=1012) {
+        ret=peek_head1009(frame,len,head,t);
+        glo=1;
+    }
+    else if (1071<=type&&type<=1137&&1<=type%10&&type%10<=7) {
+        sys=msm_sys[(type-1070)/10];
+        init_bitrd(&rd,frame,len,24+12);
+        ret=peek_msm_head(&rd,sys,head,t,&iod,&h);
+        glo=sys==SYS_GLO;
+    }
+    else if ((ssr=ssr_type(frame,len,type,&sys,&subtype))) {
+        init_bitrd(&rd,frame,len,24+12);
+        ret=peek_ssr_head(&rd,sys,subtype,ssr,head,t);
+        glo=subtype==0&&sys==SYS_GLO;
+    }
+    else {
+        if (msg_rtcm3[MSGIDX(type)].flag&MSGF_STA) { /* station messages */
+            if (24+12+12>len*8) return -1;
+            head->staid=getbitu(frame,24+12,12);
+        }
+        return 0;
+    }
+    if (ret<0) {
+        trace(2,"rtcm3 %d length error: len=%d\n",type,len);
+        return -1;
+    }
+    return glo?2:1;
+}
+/* epoch time nearest to reference time (time0: reference time, NULL: cpu) ---*/
+static gtime_t resolve_epoch(const gtime_t *time0, int tsys, double t)
+{
+    gtime_t time=time0&&time0->time?*time0:timeget_ref();
+    return tsys==2?tod2time(time,t):tow2time(time,t);
+}
+/* test and register duplicate frame (len: message length without parity) --*/
+static int test_dup(rtcm_dedup_t *dedup, const uint8_t *frame, int len)
+{
+    rtcm_dupfrm_t *p;
+    rtcm_head_t head;
+    gtime_t time;
+    double t=0.0;
+    uint32_t crc,epoch=0,h;
+    int tsys,dup=0;
+
+    crc=getbitu(frame,len*8,24);
+    tsys=peek_epoch(frame,len+3,&head,&t);
+    h=crc^(uint32_t)head.type*0x9E3779B1u^(uint32_t)head.staid*0x85EBCA6Bu;
+
+    lock(&dedup->lock);
+
+    if (tsys>0) {
+        time=resolve_epoch(&dedup->time,tsys,t);
+        if (dedup->time.time==0||timediff(time,dedup->time)>0.0) {
+            dedup->time=time;
+        }
+        epoch=(uint32_t)floor(t*1000.0+0.5);
+    }
+    h^=epoch*0xC2B2AE35u;
+    p=dedup->frm+((h^h>>16)&(MAXDUPFRM-1));
+
+    if (p->len==len&&p->crc==crc&&p->type==head.type&&p->staid==head.staid&&
+        p->epoch==epoch&&timediff(dedup->time,p->time)<=dedup->window) {
+        dedup->ndup++;
+        dup=1;
+    }
+    else {
+        p->crc=crc;
+        p->type=(uint16_t)head.type;
+        p->staid=(uint16_t)head.staid;
+        p->epoch=epoch;
+        p->len=len;
+        p->time=dedup->time;
+        dedup->npass++;
+    }
+    unlock(&dedup->lock);
+
+    if (dup) trace(3,"rtcm3 %d duplicate frame: staid=%d\n",head.type,head.staid);
+    return dup;
+}
+/* peek message header (time0: reference time, NULL: cpu time) ---------------*/
+static int peek_head(const gtime_t *time0, const uint8_t *frame, int len,
+                     rtcm_head_t *head)
+{
+    double t;
+    int tsys;
+
+    if ((tsys=peek_epoch(frame,len,head,&t))<=0) return tsys;
+    head->time=resolve_epoch(time0,tsys,t);
+    return 1;
+}
+/* peek RTCM 3 message header --------------------------------------------------
+* decode message type, station id, epoch time and number of satellites of a
+* RTCM 3 frame without decoding observation, ephemeris or correction data
+* args   : rtcm_t *rtcm     I   rtcm control struct (NULL: no reference time)
+*          uint8_t *frame   I   RTCM 3 frame (preamble to parity)
+*          int    len       I   frame length (bytes)
+*          rtcm_head_t *head O  message header
+* return : status (-1: error message, 0: type and station id only,
+*                  1: header with epoch time)
+* notes  : the parity of the frame is not checked.
+*          the epoch time is resolved to the nearest to the time of the last
+*          message decoded by rtcm control struct (cpu time if no time, read
+*          by timeget_ref() once per second).
+*          rtcm control struct is not modified.
+*-----------------------------------------------------------------------------*/
+extern int peek_rtcm3(const rtcm_t *rtcm, const uint8_t *frame, int len,
+                      rtcm_head_t *head)
+{
+    trace(4,"peek_rtcm3: len=%d\n",len);
+
+    return peek_head(rtcm?&rtcm->time:NULL,frame,len,head);
+}
+/* scan RTCM 3 frames in buffer ------------------------------------------------
+* search valid RTCM 3 frames in a buffer of byte stream and generate the
+* frame index records by the frame headers
+* args   : gtime_t *time    IO  reference time (time.time=0: cpu time)
+*          uint8_t *buff    I   stream data
+*          size_t len       I   stream data length (bytes)
+*          rtcm_index_t *index O frame index records
+*          int    nmax      I   max number of index records
+*          size_t *consumed O   number of bytes scanned in the buffer
+* return : number of index records
+* notes  : only the framing, the parity and the frame header are decoded.
+*          the reference time is updated by the epoch time of each frame to
+*          resolve week and day rollover of the following frames, so set the
+*          time within a half week of the start of the stream for a log file.
+*          a frame overrunning the buffer is skipped if a valid frame follows
+*          it, otherwise scanning stops before the incomplete frame at the end
+*          of buffer. call it again from buff+consumed to continue.
+*-----------------------------------------------------------------------------*/
+extern int scan_rtcm3(gtime_t *time, const uint8_t *buff, size_t len,
+                      rtcm_index_t *index, int nmax, size_t *consumed)
+{
+    rtcm_head_t head;
+    size_t i=0,tail=len;
+    double t=0.0;
+    int n=0,flen,tsys;
+
+    trace(4,"scan_rtcm3: len=%d nmax=%d\n",(int)len,nmax);
+
+    while (n<nmax) {
+        if ((i+=sync_frame(buff+i,len-i))+3>len) break;
+        flen=getbitu(buff+i,14,10)+6;
+
+        /* false preamble or incomplete frame at the end of buffer */
+        if (i+flen>len) {
+            if (tail==len) tail=i;
+            i++;
+            continue;
+        }
+
+        /* check parity */
+        if (rtk_crc24q(buff+i,flen-3)!=getbitu(buff+i,(flen-3)*8,24)) {
+            i++;
+            continue;
+        }
+        if ((tsys=peek_epoch(buff+i,flen,&head,&t))>0) {
+            *time=resolve_epoch(time,tsys,t);
+        }
+        index[n].offset=i;
+        index[n].len=flen;
+        index[n].type=head.type;
+        index[n].staid=head.staid;
+        index[n].tsys=tsys>0?tsys:0;
+        index[n].tow=tsys>0?t:0.0;
+        index[n++].time=*time;
+        i+=flen;
+        tail=len;
+    }
+    *consumed=tail<i?tail:i;
+    return n;
+}
+/* resolve epoch time of RTCM 3 message ----------------------------------------
+* resolve week or day rollover of epoch time in RTCM 3 message
+* args   : gtime_t time     I   reference time (time.time=0: cpu time)
+*          int    tsys      I   epoch time system (1:GPST tow,2:GLONASS tod)
+*          double tow       I   epoch time of week or day (s)
+* return : epoch time (GPST) nearest to the reference time
+* notes  : tsys and tow are given by scan_rtcm3() in frame index record.
+*-----------------------------------------------------------------------------*/
+extern gtime_t resolve_rtcm3(gtime_t time, int tsys, double tow)
+{
+    return resolve_epoch(&time,tsys,tow);
+}
+/* enable or disable message types -------------------------------------------
+* enable or disable decoding of message types in rtcm control struct
+* args   : rtcm_t *rtcm     IO  rtcm control struct
+*          int    type1     I   first message type (0-4095)
+*          int    type2     I   last message type (0-4095)
+*          int    ena       I   enable (1:enable,0:disable)
+* return : none
+* notes  : all message types are enabled by init_rtcm(). a frame of disabled
+*          message type is counted in rtcm->nmask without decoding.
+*-----------------------------------------------------------------------------*/
+extern void set_rtcm_type(rtcm_t *rtcm, int type1, int type2, int ena)
+{
+    int type;
+
+    trace(3,"set_rtcm_type: type=%d-%d ena=%d\n",type1,type2,ena);
+
+    if (type1<0) type1=0;
+    if (type2>4095) type2=4095;
+    for (type=type1;type<=type2;type++) {
+        if (ena) rtcm->tmask[type>>5]|= 1u<<(type&31);
+        else     rtcm->tmask[type>>5]&=~(1u<<(type&31));
+    }
+}
+/* enable or disable avx2 msm cell unpacking -----------------------------------
+* enable or disable unpacking of msm satellite and cell data by avx2
+* args   : int    ena       I   enable (1:enable if supported,0:disable)
+* return : status (1:unpacked by avx2,0:unpacked by scalar reads)
+* notes  : the option is common to all rtcm control structs and has to be set
+*          out of decoding. the decoded data are identical in both the ways.
+*-----------------------------------------------------------------------------*/
+extern int set_rtcm_avx2(int ena)
+{
+    trace(3,"set_rtcm_avx2: ena=%d\n",ena);
+
+#ifdef MSM_AVX2
+    msm_avx2=ena;
+    return ena&&__builtin_cpu_supports("avx2");
+#else
+    return 0;
+#endif
+}
+/* get message class -----------------------------------------------------------
+* get message class of message type by message type descriptor
+* args   : int    type      I   message type (0-4095)
+* return : message class (MSGF_???, 0:other or unsupported type)
+*-----------------------------------------------------------------------------*/
+extern int get_rtcm_class(int type)
+{
+    if (type<0||type>4095) return 0;
+    return msg_rtcm3[MSGIDX(type)].flag;
+}
+/* get message count ----------------------------------------------------------
+* get number of decoded frames of message type in rtcm control struct
+* args   : rtcm_t *rtcm     I   rtcm control struct
+*          int    type      I   message type (0-4095)
+* return : number of decoded frames (0:no frame or unsupported type)
+*-----------------------------------------------------------------------------*/
+extern uint32_t get_rtcm_count(const rtcm_t *rtcm, int type)
+{
+    int idx;
+
+    if (type<0||type>4095||!(idx=MSGIDX(type))) return 0;
+    return rtcm->nmsg3[idx];
+}
+/* initialize duplicate frame filter ------------------------------------------
+* initialize duplicate frame filter shared by rtcm control structs of
+* redundant streams of the same sources
+* args   : rtcm_dedup_t *dedup O duplicate frame filter
+*          double window    I   time window of duplicate frames (s)
+* return : none
+* notes  : set rtcm->dedup to the filter to drop the frames identical to a
+*          frame passed in the time window before decoding. the frames are
+*          identified by the parity, message type, station id and epoch time.
+*          the filter is locked in the test of a frame, so rtcm control structs
+*          sharing it can be decoded in parallel threads.
+*          a frame of message type disabled by set_rtcm_type() is neither
+*          tested nor registered, so it does not drop the frame of the other
+*          streams.
+*          the filter time is the latest epoch time of the frames, so a
+*          message without epoch time repeated in the window is also dropped.
+*-----------------------------------------------------------------------------*/
+extern void init_rtcm_dedup(rtcm_dedup_t *dedup, double window)
+{
+    gtime_t time0={0};
+    int i;
+
+    trace(3,"init_rtcm_dedup: window=%.1f\n",window);
+
+    dedup->window=window;
+    dedup->time=time0;
+    dedup->npass=dedup->ndup=0;
+    for (i=0;i<MAXDUPFRM;i++) {
+        dedup->frm[i].len=0;
+    }
+    initlock(&dedup->lock);
+}
+/* get statistics of duplicate frame filter ------------------------------------
+* get numbers of frames passed and dropped by duplicate frame filter
+* args   : rtcm_dedup_t *dedup IO duplicate frame filter
+*          uint32_t *npass  O   number of frames passed
+*          uint32_t *ndup   O   number of duplicate frames dropped
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void get_rtcm_dedup(rtcm_dedup_t *dedup, uint32_t *npass,
+                          uint32_t *ndup)
+{
+    lock(&dedup->lock);
+    *npass=dedup->npass;
+    *ndup=dedup->ndup;
+    unlock(&dedup->lock);
 }
 /* initialize rtcm control -----------------------------------------------------
 * initialize rtcm control struct and reallocate memory for observation and
@@ -2818,11 +3912,17 @@ extern int init_rtcm(rtcm_t *rtcm)
     }
     rtcm->sta.hgt=0.0;
     rtcm->dgps=NULL;
+    rtcm->dedup=NULL;
     for (i=0;i<MAXSAT;i++) {
         rtcm->ssr[i]=ssr0;
     }
     rtcm->msg[0]=rtcm->msgtype[0]=rtcm->opt[0]='\0';
-    for (i=0;i<6;i++) rtcm->msmtype[i][0]='\0';
+    for (i=0;i<7;i++) {
+        rtcm->msmtype[i][0]='\0';
+        rtcm->msmsig[i].nsig=-1;
+        rtcm->msmsig[i].priver=0;
+    }
+    rtcm->msmopt[0]='\0';
     rtcm->obsflag=rtcm->ephsat=0;
     for (i=0;i<MAXSAT;i++) for (j=0;j<NFREQ+NEXOBS;j++) {
         rtcm->cp[i][j]=0.0;
@@ -2830,9 +3930,17 @@ extern int init_rtcm(rtcm_t *rtcm)
         rtcm->lltime[i][j]=time0;
     }
     rtcm->nbyte=rtcm->nbit=rtcm->len=0;
+    rtcm->pbuff=NULL;
+    rtcm->parity=0;
+    rtcm->recov=0;
+    rtcm->mixed=rtcm->flen=rtcm->fline=0;
+    rtcm->relay=rtcm->rlen=0;
+    rtcm->rframe=NULL;
+    rtcm->nskip=rtcm->nrecov=rtcm->nreject=rtcm->nmask=rtcm->nforeign=0;
+    for (i=0;i<128;i++) rtcm->tmask[i]=0xFFFFFFFF;
+    for (i=0;i<MAXMSG3;i++) rtcm->nmsg3[i]=0;
     // rtcm->word=0;
     // for (i=0;i<100;i++) rtcm->nmsg2[i]=0;
-    // for (i=0;i<400;i++) rtcm->nmsg3[i]=0;
 
     rtcm->obs.data=NULL;
     rtcm->nav.eph =NULL;
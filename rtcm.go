@@ -2,13 +2,18 @@ package rtcm
 
 /*
 #cgo CFLAGS: -I./ -DENAGLO -DENAGAL -DENAQZS -DENACMP -DENAIRN
+#cgo !windows LDFLAGS: -lpthread
 
+#include <stdlib.h>
 #include "rtkcmn.h"
 #include "rtcm.h"
 */
 import "C"
 import (
 	"errors"
+	"fmt"
+	"net"
+	"runtime"
 	"unsafe"
 )
 
@@ -16,6 +21,7 @@ var (
 	ErrIncomplete = errors.New("incomplete data")
 	ErrCrc        = errors.New("crc error")
 	ErrInvalid    = errors.New("invalid data")
+	ErrMemory     = errors.New("memory allocation error")
 )
 
 // GtimeT time struct
@@ -367,13 +373,147 @@ type Rtcm struct {
 // Cdecode decode the rtcm data and return the C.rtcm_t
 func Cdecode(data []byte) (rtcm C.rtcm_t, err error) {
 	C.init_rtcm(&rtcm)
-	for _, d := range data {
-		C.input_rtcm3(&rtcm, C.uint8_t(d))
-	}
+	inputBuf(&rtcm, data)
 	C.free_rtcm(&rtcm)
 	return
 }
 
+// inputBuf input the rtcm data by chunk and return the status of the last input
+func inputBuf(crtcm *C.rtcm_t, data []byte) (status int) {
+	for len(data) > 0 || frameReady(crtcm) {
+		var consumed C.size_t
+		status = int(C.input_rtcm3_buf(crtcm, cbytes(data), C.size_t(len(data)), &consumed))
+		data = data[consumed:]
+	}
+	return
+}
+
+// frameReady test whether a complete frame recovered after parity error is
+// left in the message buffer
+func frameReady(crtcm *C.rtcm_t) bool {
+	return crtcm.flen == 0 && crtcm.nbyte >= 3 && crtcm.nbyte >= crtcm.len+3
+}
+
+// frameLen return the frame length from the frame header, 0 for no header
+func frameLen(data []byte) int {
+	if len(data) < 3 || data[0] != 0xd3 || data[1]&0xfc != 0 {
+		return 0
+	}
+	return (int(data[1]&0x03)<<8 | int(data[2])) + 6
+}
+
+// cbytes return the C pointer to the data, nil for empty data
+func cbytes(data []byte) *C.uint8_t {
+	if len(data) == 0 {
+		return nil
+	}
+	return (*C.uint8_t)(unsafe.Pointer(&data[0]))
+}
+
+// getbitu extract unsigned bits by C.getbitu
+func getbitu(buff []byte, pos, n int) uint32 {
+	return uint32(C.getbitu(cbytes(buff), C.int(pos), C.int(n)))
+}
+
+// getbits extract signed bits by C.getbits
+func getbits(buff []byte, pos, n int) int32 {
+	return int32(C.getbits(cbytes(buff), C.int(pos), C.int(n)))
+}
+
+// codepri get code priority by C.getcodepri
+func codepri(sys, code int, opt string) int {
+	copt := C.CString(opt)
+	defer C.free(unsafe.Pointer(copt))
+	return int(C.getcodepri(C.int(sys), C.uint8_t(code), copt))
+}
+
+// setcodepri set code priorities of the frequency index by C.setcodepri
+func setcodepri(sys, idx int, pri string) {
+	cpri := C.CString(pri)
+	defer C.free(unsafe.Pointer(cpri))
+	C.setcodepri(C.int(sys), C.int(idx), cpri)
+}
+
+// codepris get code priorities of all codes by C.getcodepris
+func codepris(sys int, opt string) []int {
+	var cpri [C.MAXCODE + 1]C.uint8_t
+	copt := C.CString(opt)
+	defer C.free(unsafe.Pointer(copt))
+	C.getcodepris(C.int(sys), copt, &cpri[0])
+	pri := make([]int, len(cpri))
+	for i := range cpri {
+		pri[i] = int(cpri[i])
+	}
+	return pri
+}
+
+// obs2code convert obs code string to obs code by C.obs2code
+func obs2code(obs string) int {
+	cobs := C.CString(obs)
+	defer C.free(unsafe.Pointer(cobs))
+	return int(C.obs2code(cobs))
+}
+
+// code2obs convert obs code to obs code string by C.code2obs
+func code2obs(code int) string {
+	return C.GoString(C.code2obs(C.uint8_t(code)))
+}
+
+// code2freq convert system and obs code to carrier frequency by C.code2freq
+func code2freq(sys, code, fcn int) float64 {
+	return float64(C.code2freq(C.int(sys), C.uint8_t(code), C.int(fcn)))
+}
+
+// setAvx2 enable or disable MSM cell unpacking by AVX2 by C.set_rtcm_avx2,
+// return whether the cells are unpacked by AVX2
+func setAvx2(ena bool) bool {
+	return C.set_rtcm_avx2(C.int(b2i(ena))) != 0
+}
+
+// timeset set the current time (utc) got by C.timeget by C.timeset
+func timeset(t GtimeT) {
+	C.timeset(C.gtime_t{time: C.time_t(t.Time), sec: C.double(t.Sec)})
+}
+
+// timereset reset the current time got by C.timeget by C.timereset
+func timereset() {
+	C.timereset()
+}
+
+// setTime set the approximate time of the decoder (rtcm_t.time)
+func (d *Decoder) setTime(t GtimeT) {
+	d.crtcm.time = C.gtime_t{time: C.time_t(t.Time), sec: C.double(t.Sec)}
+}
+
+// decodeFrame decode a complete frame by C.decode_rtcm3_frame and return the
+// status and the decoded data
+func (d *Decoder) decodeFrame(frame []byte) (int, Rtcm) {
+	status := int(C.decode_rtcm3_frame(d.crtcm, cbytes(frame), C.int(len(frame))))
+	return status, convertRtcm(d.crtcm)
+}
+
+// message get the special message of the decoder (rtcm_t.msg)
+func (d *Decoder) message() string {
+	return C.GoString(&d.crtcm.msg[0])
+}
+
+// msmTypes get the MSM signal types of the systems decoded by the decoder
+// (rtcm_t.msmtype)
+func (d *Decoder) msmTypes() []string {
+	types := make([]string, len(d.crtcm.msmtype))
+	for i := range types {
+		types[i] = C.GoString(&d.crtcm.msmtype[i][0])
+	}
+	return types
+}
+
+// setOpt set the decoding options of the decoder (rtcm_t.opt)
+func (d *Decoder) setOpt(opt string) {
+	copt := C.CString(opt)
+	defer C.free(unsafe.Pointer(copt))
+	C.strncpy(&d.crtcm.opt[0], copt, C.size_t(len(d.crtcm.opt)-1))
+}
+
 // convertObs convert C.obs_t to go ObsT
 func convertObs(cobs C.obs_t) ObsT {
 	obs := ObsT{
@@ -647,8 +787,10 @@ func Decode(data []byte) (rtcm Rtcm, err error) {
 	C.init_rtcm(&crtcm)
 
 	var status int
-	for _, d := range data {
-		status = int(C.input_rtcm3(&crtcm, C.uint8_t(d)))
+	if frameLen(data) == len(data) {
+		status = int(C.decode_rtcm3_frame(&crtcm, cbytes(data), C.int(len(data))))
+	} else {
+		status = inputBuf(&crtcm, data)
 	}
 
 	rtcm.Type = int(crtcm.mtype)
@@ -670,6 +812,18 @@ func Decode(data []byte) (rtcm Rtcm, err error) {
 		return
 	}
 
+	rtcm = convertRtcm(&crtcm)
+
+	C.free_rtcm(&crtcm)
+	return
+}
+
+// convertRtcm convert C.rtcm_t to go Rtcm
+func convertRtcm(crtcm *C.rtcm_t) (rtcm Rtcm) {
+	rtcm.Type = int(crtcm.mtype)
+	rtcm.Crc = int(crtcm.crc)
+	rtcm.StaId = int(crtcm.staid)
+
 	rtcm.Time = GtimeT{
 		Time: int64(crtcm.time.time),
 		Sec:  float64(crtcm.time.sec),
@@ -683,8 +837,257 @@ func Decode(data []byte) (rtcm Rtcm, err error) {
 	rtcm.ObsFlag = int(crtcm.obsflag)
 	rtcm.EphSat = int(crtcm.ephsat)
 	rtcm.EphSet = int(crtcm.ephset)
+	return
+}
 
-	C.free_rtcm(&crtcm)
+// Decoder rtcm3 stream decoder keeping the decoding state between inputs
+type Decoder struct {
+	crtcm *C.rtcm_t
+	dedup *Dedup
+}
+
+// NewDecoder create a rtcm3 stream decoder, Close must be called after use
+func NewDecoder() (*Decoder, error) {
+	crtcm := (*C.rtcm_t)(C.calloc(1, C.sizeof_rtcm_t))
+	if crtcm == nil {
+		return nil, ErrMemory
+	}
+	if C.init_rtcm(crtcm) == 0 {
+		C.free(unsafe.Pointer(crtcm))
+		return nil, ErrMemory
+	}
+	return &Decoder{crtcm: crtcm}, nil
+}
+
+// Close release the decoding state of the decoder
+func (d *Decoder) Close() {
+	if d.crtcm == nil {
+		return
+	}
+	C.free_rtcm(d.crtcm)
+	C.free(unsafe.Pointer(d.crtcm))
+	d.crtcm = nil
+}
+
+// Input input a chunk of rtcm3 stream (e.g. a socket read) and return the
+// messages completed in it, an incomplete frame is continued by the next input
+func (d *Decoder) Input(data []byte) (rtcms []Rtcm) {
+	for len(data) > 0 || frameReady(d.crtcm) {
+		var consumed C.size_t
+		status := int(C.input_rtcm3_buf(d.crtcm, cbytes(data), C.size_t(len(data)), &consumed))
+		data = data[consumed:]
+
+		if status > 0 {
+			rtcms = append(rtcms, convertRtcm(d.crtcm))
+		}
+	}
+	return
+}
+
+// RelayFrame rtcm3 frame relayed without decoding
+type RelayFrame struct {
+	Data  []byte // frame (preamble to parity)
+	Type  int    // message type
+	StaId int    // station id (0:no station id)
+}
+
+// relayBatch max number of frames relayed by a cgo call
+const relayBatch = 64
+
+// Relay input a chunk of rtcm3 stream and return the frames completed in it
+// as Input but without decoding. Data of a frame refers to data except for a
+// frame continued from the previous input, which is copied. The decoding state
+// (observations, ephemerides, ...) of the decoder is not changed.
+func (d *Decoder) Relay(data []byte) (frames []RelayFrame) {
+	var iov [relayBatch]C.rtcm_iov_t
+	var head [relayBatch]C.rtcm_head_t
+	base := uintptr(unsafe.Pointer(cbytes(data)))
+
+	for len(data) > 0 || frameReady(d.crtcm) {
+		var consumed C.size_t
+		iov = [relayBatch]C.rtcm_iov_t{}
+		n := int(C.relay_rtcm3(d.crtcm, cbytes(data), C.size_t(len(data)), &iov[0], &head[0], relayBatch, &consumed))
+		for i := 0; i < n; i++ {
+			frame := RelayFrame{Type: int(head[i]._type), StaId: int(head[i].staid)}
+			if off := uintptr(iov[i].base) - base; base != 0 && off < uintptr(len(data)) {
+				frame.Data = data[off : off+uintptr(iov[i].len)]
+			} else {
+				frame.Data = C.GoBytes(iov[i].base, C.int(iov[i].len))
+			}
+			frames = append(frames, frame)
+		}
+		data = data[consumed:]
+		base = uintptr(unsafe.Pointer(cbytes(data)))
+	}
+	return
+}
+
+// RelayBuffers return the data of the frames as net.Buffers written by writev
+func RelayBuffers(frames []RelayFrame) net.Buffers {
+	bufs := make(net.Buffers, len(frames))
+	for i, f := range frames {
+		bufs[i] = f.Data
+	}
+	return bufs
+}
+
+// Stats stream statistics of the decoder
+type Stats struct {
+	SkipBytes int         // number of bytes skipped to synchronize frame
+	Recovered int         // number of frames recovered after parity error
+	Rejected  int         // number of frames rejected by message type or length
+	Disabled  int         // number of frames of disabled message types
+	Foreign   int         // number of bytes skipped in non-rtcm frames (mixed stream)
+	Types     map[int]int // number of decoded frames by message type
+}
+
+// msgType message type of the message type index of rtcm_t.nmsg3 (MSGIDX() in
+// rtcm.c, 1-299:1001-1299,300-329:4070-4099,330-429:0-99) or -1 (0:other)
+func msgType(idx int) int {
+	switch {
+	case idx >= 1 && idx < 300:
+		return idx + 1000
+	case idx >= 300 && idx < 330:
+		return idx + 3770
+	case idx >= 330 && idx < 430:
+		return idx - 330
+	}
+	return -1
+}
+
+// Stats return the stream statistics of the decoder
+func (d *Decoder) Stats() Stats {
+	types := make(map[int]int)
+	for idx, n := range d.crtcm.nmsg3 {
+		if typ := msgType(idx); typ >= 0 && n > 0 {
+			types[typ] = int(n)
+		}
+	}
+	return Stats{
+		SkipBytes: int(d.crtcm.nskip),
+		Recovered: int(d.crtcm.nrecov),
+		Rejected:  int(d.crtcm.nreject),
+		Disabled:  int(d.crtcm.nmask),
+		Foreign:   int(d.crtcm.nforeign),
+		Types:     types,
+	}
+}
+
+// SetMixed set the mixed stream mode of the decoder, NMEA sentences and UBX,
+// SBF and NovAtel binary frames interleaved with rtcm3 frames are skipped
+// without searching rtcm3 frames in them
+func (d *Decoder) SetMixed(mixed bool) {
+	d.crtcm.mixed = C.int(b2i(mixed))
+}
+
+// EnableTypes enable decoding of only the message types, the frames of the
+// other message types are counted without decoding (no types: all types)
+func (d *Decoder) EnableTypes(types ...int) {
+	C.set_rtcm_type(d.crtcm, 0, 4095, C.int(b2i(len(types) == 0)))
+	for _, typ := range types {
+		C.set_rtcm_type(d.crtcm, C.int(typ), C.int(typ), 1)
+	}
+}
+
+// DisableTypes disable decoding of the message types, the frames of the
+// message types are counted without decoding
+func (d *Decoder) DisableTypes(types ...int) {
+	for _, typ := range types {
+		C.set_rtcm_type(d.crtcm, C.int(typ), C.int(typ), 0)
+	}
+}
+
+// Dedup duplicate frame filter shared by the decoders of redundant streams of
+// the same sources, a frame identical to a frame passed within the time window
+// is dropped before decoding
+type Dedup struct {
+	cdedup *C.rtcm_dedup_t
+}
+
+// DedupStats statistics of the duplicate frame filter
+type DedupStats struct {
+	Passed  int // number of frames passed
+	Dropped int // number of duplicate frames dropped
+}
+
+// NewDedup create a duplicate frame filter with the time window (s), Close
+// must be called after the decoders using it are closed
+func NewDedup(window float64) (*Dedup, error) {
+	cdedup := (*C.rtcm_dedup_t)(C.calloc(1, C.sizeof_rtcm_dedup_t))
+	if cdedup == nil {
+		return nil, ErrMemory
+	}
+	C.init_rtcm_dedup(cdedup, C.double(window))
+	return &Dedup{cdedup: cdedup}, nil
+}
+
+// Close release the duplicate frame filter
+func (f *Dedup) Close() {
+	if f.cdedup == nil {
+		return
+	}
+	C.free(unsafe.Pointer(f.cdedup))
+	f.cdedup = nil
+}
+
+// Stats return the statistics of the duplicate frame filter
+func (f *Dedup) Stats() DedupStats {
+	var npass, ndup C.uint32_t
+	C.get_rtcm_dedup(f.cdedup, &npass, &ndup)
+	return DedupStats{
+		Passed:  int(npass),
+		Dropped: int(ndup),
+	}
+}
+
+// SetDedup set the duplicate frame filter of the decoder (nil: no filter),
+// the decoders sharing a filter can input on different goroutines
+func (d *Decoder) SetDedup(f *Dedup) {
+	d.dedup = f
+	d.crtcm.dedup = nil
+	if f != nil {
+		d.crtcm.dedup = f.cdedup
+	}
+}
+
+// Head rtcm3 message header for routing
+type Head struct {
+	Type  int    // message type
+	StaId int    // station id (0:no station id)
+	Time  GtimeT // epoch time (GPST) (Time.Time=0:no epoch time)
+	Nsat  int    // number of satellites
+	Sync  int    // synchronous GNSS flag
+}
+
+// Peek decode the header of a rtcm3 frame without decoding the message body,
+// the epoch time is resolved to the nearest to the current time
+func Peek(frame []byte) (Head, error) {
+	return peek(nil, frame)
+}
+
+// Peek decode the header of a rtcm3 frame without changing the decoding state,
+// the epoch time is resolved to the nearest to the last decoded message time
+func (d *Decoder) Peek(frame []byte) (Head, error) {
+	return peek(d.crtcm, frame)
+}
+
+// peek decode the header of a rtcm3 frame by C.peek_rtcm3
+func peek(crtcm *C.rtcm_t, frame []byte) (head Head, err error) {
+	var chead C.rtcm_head_t
+	if C.peek_rtcm3(crtcm, cbytes(frame), C.int(len(frame)), &chead) < 0 {
+		err = ErrInvalid
+		return
+	}
+	head = Head{
+		Type:  int(chead._type),
+		StaId: int(chead.staid),
+		Time: GtimeT{
+			Time: int64(chead.time.time),
+			Sec:  float64(chead.time.sec),
+		},
+		Nsat: int(chead.nsat),
+		Sync: int(chead.sync),
+	}
 	return
 }
 
@@ -696,13 +1099,59 @@ func CheckCrc(data []byte) bool {
 	}
 
 	checkLen := dataLen - 3
-	cdata := (*C.uint8_t)(unsafe.Pointer(&data[0]))
-	checkVal := C.rtk_crc24q(cdata, C.int(checkLen))
-	crcVal := C.getbitu(cdata, C.int(checkLen*8), 24)
+	checkVal := uint32(C.rtk_crc24q(cbytes(data), C.int(checkLen)))
+	crcVal := getbitu(data, checkLen*8, 24)
 
 	return checkVal == crcVal
 }
 
+// CrcBitmap validity bitmap of frames (frame i: bit i%8 of byte i/8)
+type CrcBitmap []byte
+
+// Valid test whether the frame i is valid
+func (b CrcBitmap) Valid(i int) bool {
+	return b[i/8]>>uint(i%8)&1 != 0
+}
+
+// crcBatch number of frames checked by a goroutine at least
+const crcBatch = 4096
+
+// CheckCrcs check crc of the frames packed in data, frame i is
+// data[offsets[i]:offsets[i+1]] (len(offsets)-1 frames), and return the
+// validity bitmap and the number of valid frames, a large batch is checked on
+// multiple goroutines. CheckCrcs panics like slicing if the offsets are
+// decreasing or out of range of data
+func CheckCrcs(data []byte, offsets []int) (CrcBitmap, int) {
+	n := len(offsets) - 1
+	if n <= 0 {
+		return nil, 0
+	}
+	coffsets := make([]C.size_t, len(offsets))
+	prev := 0
+	for i, off := range offsets {
+		if off < prev || off > len(data) {
+			panic(fmt.Sprintf("rtcm: CheckCrcs offsets[%d] %d out of range [%d:%d]", i, off, prev, len(data)))
+		}
+		coffsets[i] = C.size_t(off)
+		prev = off
+	}
+	valid := make(CrcBitmap, (n+7)/8)
+	nvalid := make([]int, (n+crcBatch-1)/crcBatch)
+
+	parallelFor(len(nvalid), runtime.GOMAXPROCS(0), func(k int) {
+		i, m := k*crcBatch, crcBatch
+		if m > n-i {
+			m = n - i
+		}
+		nvalid[k] = int(C.check_rtcm3_crc(cbytes(data), &coffsets[i], C.int(m), (*C.uint8_t)(&valid[i/8])))
+	})
+	total := 0
+	for _, v := range nvalid {
+		total += v
+	}
+	return valid, total
+}
+
 // EcefToLla transform ecef to geodetic postion
 func EcefToLla(ecef [3]float64) [3]float64 {
 	var llh [3]float64
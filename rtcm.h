@@ -38,6 +38,11 @@
 #include <time.h>
 #include <ctype.h>
 #include <stdint.h>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -263,10 +268,18 @@ extern "C" {
 #define MAXLEAPS    64                  /* max number of leap seconds table */
 #define MAXGISLAYER 32                  /* max number of GIS data layers */
 #define MAXRCVCMD   4096                /* max length of receiver commands */
+#define MAXDUPFRM   4096                /* number of duplicate frame filter slots (2^n) */
+#define MAXMSG3     430                 /* number of RTCM 3 message type indexes */
 
 #define RNX2VER     2.10                /* RINEX ver.2 default output version */
 #define RNX3VER     3.00                /* RINEX ver.3 default output version */
 
+#define MSGF_OBS    0x01                /* message class: observation data */
+#define MSGF_EPH    0x02                /* message class: ephemerides */
+#define MSGF_SSR    0x04                /* message class: ssr corrections */
+#define MSGF_STA    0x08                /* message class: station and antenna info */
+#define MSGF_FCN    0x10                /* message class: GLONASS obs with fcn */
+
 #define OBSTYPE_PR  0x01                /* observation type: pseudorange */
 #define OBSTYPE_CP  0x02                /* observation type: carrier-phase */
 #define OBSTYPE_DOP 0x04                /* observation type: doppler-freq */
@@ -506,6 +519,18 @@ extern "C" {
 #define P2_50       8.881784197001252E-16 /* 2^-50 */
 #define P2_55       2.775557561562891E-17 /* 2^-55 */
 
+#ifdef WIN32
+#define lock_t      CRITICAL_SECTION
+#define initlock(f) InitializeCriticalSection(f)
+#define lock(f)     EnterCriticalSection(f)
+#define unlock(f)   LeaveCriticalSection(f)
+#else
+#define lock_t      pthread_mutex_t
+#define initlock(f) pthread_mutex_init(f,NULL)
+#define lock(f)     pthread_mutex_lock(f)
+#define unlock(f)   pthread_mutex_unlock(f)
+#endif
+
 /* type definitions ----------------------------------------------------------*/
 
 typedef struct {        /* time struct */
@@ -772,6 +797,57 @@ typedef struct {        /* station parameter type */
     double glo_cp_bias[4]; /* GLONASS code-phase biases {1C,1P,2C,2P} (m) */
 } sta_t;
 
+typedef struct {        /* RTCM message header type */
+    int type;           /* message type */
+    int staid;          /* station id (0:no station id) */
+    gtime_t time;       /* epoch time (GPST) (time.time=0:no epoch time) */
+    int nsat;           /* number of satellites */
+    int sync;           /* synchronous GNSS flag */
+} rtcm_head_t;
+
+typedef struct {        /* RTCM frame index record type */
+    size_t offset;      /* frame offset in buffer (bytes) */
+    int len;            /* frame length (bytes) */
+    int type;           /* message type */
+    int staid;          /* station id (0:no station id) */
+    gtime_t time;       /* epoch time (GPST) (last epoch time if no epoch) */
+    int tsys;           /* epoch time system (0:none,1:GPST tow,2:GLONASS tod) */
+    double tow;         /* epoch time of week or day in the time system (s) */
+} rtcm_index_t;
+
+typedef struct {        /* RTCM relay frame type (layout of struct iovec) */
+    const void *base;   /* frame (preamble to parity) */
+    size_t len;         /* frame length (bytes) */
+} rtcm_iov_t;
+
+typedef struct {        /* RTCM duplicate frame filter slot type */
+    uint32_t crc;       /* frame parity (crc-24q) */
+    uint16_t type;      /* message type */
+    uint16_t staid;     /* station id */
+    uint32_t epoch;     /* epoch time of week or day (ms) (0:no epoch) */
+    int len;            /* message length (bytes) (0:empty slot) */
+    gtime_t time;       /* filter time when the frame passed */
+} rtcm_dupfrm_t;
+
+typedef struct {        /* RTCM duplicate frame filter type */
+    double window;      /* time window of duplicate frames (s) */
+    gtime_t time;       /* filter time (latest epoch time of frames) */
+    uint32_t npass;     /* number of frames passed */
+    uint32_t ndup;      /* number of duplicate frames dropped */
+    rtcm_dupfrm_t frm[MAXDUPFRM]; /* recent frames by hash of frame key */
+    lock_t lock;        /* lock flag */
+} rtcm_dedup_t;
+
+typedef struct {        /* MSM signal mapping type */
+    int nsig;           /* number of signals (-1: no mapping) */
+    uint32_t mask;      /* signal mask (msb: signal id 1) */
+    uint8_t code[32];   /* obs codes of signals */
+    int idx[32];        /* obs data indices of signals (-1: not saved) */
+    double freq[32];    /* carrier frequencies of signals (Hz) (GLONASS: fcn=0) */
+    uint32_t priver;    /* version of code priorities (0: not built) */
+    uint8_t pri[MAXCODE+1]; /* code priorities by obs code (getcodepris()) */
+} rtcm_msmsig_t;
+
 typedef struct {        /* RTCM control struct type */
     int mtype;          /* message type */
     int crc;            /* crc error */
@@ -783,10 +859,13 @@ typedef struct {        /* RTCM control struct type */
     nav_t nav;          /* satellite ephemerides */
     sta_t sta;          /* station parameters */
     dgps_t *dgps;       /* output of dgps corrections */
+    rtcm_dedup_t *dedup; /* duplicate frame filter (NULL: no filter) */
     ssr_t ssr[MAXSAT];  /* output of ssr corrections */
     char msg[128];      /* special message */
     char msgtype[256];  /* last message type */
     char msmtype[7][128]; /* msm signal types */
+    rtcm_msmsig_t msmsig[7]; /* msm signal mappings of last signal masks */
+    char msmopt[256];   /* options of msm signal mappings */
     int obsflag;        /* obs data complete flag (1:ok,0:not complete) */
     int ephsat;         /* input ephemeris satellite number */
     int ephset;         /* input ephemeris set (0-1) */
@@ -797,10 +876,26 @@ typedef struct {        /* RTCM control struct type */
     int nbyte;          /* number of bytes in message buffer */
     int nbit;           /* number of bits in word buffer */
     int len;            /* message length (bytes) */
-    uint8_t buff[1200]; /* message buffer */
+    uint32_t parity;    /* crc-24q parity of message in buffer (running) */
+    int recov;          /* number of bytes in buffer rescanned after parity error */
+    int mixed;          /* mixed stream mode (skip NMEA,UBX,SBF,NovAtel) */
+    int flen;           /* length of non-RTCM frame in mixed stream (bytes) */
+    int fline;          /* max bytes to skip to end of NMEA sentence */
+    uint32_t nskip;     /* number of bytes skipped to synchronize frame */
+    uint32_t nforeign;  /* number of bytes skipped in non-RTCM frames */
+    uint32_t nrecov;    /* number of frames recovered after parity error */
+    uint32_t nreject;   /* number of frames rejected by type or length check */
+    uint32_t nmask;     /* number of frames of disabled message types */
+    uint32_t tmask[128]; /* enabled message types (tmask[type/32] bit type%32) */
+    uint32_t nmsg3[MAXMSG3]; /* message count of RTCM 3 (1-299:1001-1299,300-329:4070-4099,330-429:0-99,0:other) */
+    uint8_t buff[MAXRAWLEN]; /* message buffer (RTCM 3 or non-RTCM frame) */
+    const uint8_t *pbuff; /* message in decoding (buff or caller's frame) */
+    int relay;          /* relay frames without decoding (relay_rtcm3()) */
+    const uint8_t *rframe; /* last relayed frame (caller's buffer or rbuff) */
+    int rlen;           /* last relayed frame length (bytes) */
+    uint8_t rbuff[1200]; /* relayed frame continued from previous input */
     // uint32_t word;      /* word buffer for rtcm 2 */
     // uint32_t nmsg2[100]; /* message count of RTCM 2 (1-99:1-99,0:other) */
-    // uint32_t nmsg3[400]; /* message count of RTCM 3 (1-299:1001-1299,300-329:4070-4099,0:ohter) */
     char opt[256];      /* RTCM dependent options */
 } rtcm_t;
 
@@ -808,6 +903,26 @@ typedef struct {        /* RTCM control struct type */
 EXPORT int init_rtcm   (rtcm_t *rtcm);
 EXPORT void free_rtcm  (rtcm_t *rtcm);
 EXPORT int input_rtcm3 (rtcm_t *rtcm, uint8_t data);
+EXPORT int input_rtcm3_buf(rtcm_t *rtcm, const uint8_t *buff, size_t len,
+                           size_t *consumed);
+EXPORT int relay_rtcm3(rtcm_t *rtcm, const uint8_t *buff, size_t len,
+                       rtcm_iov_t *iov, rtcm_head_t *head, int nmax,
+                       size_t *consumed);
+EXPORT int decode_rtcm3_frame(rtcm_t *rtcm, const uint8_t *frame, int len);
+EXPORT int check_rtcm3_crc(const uint8_t *buff, const size_t *offset, int n,
+                           uint8_t *valid);
+EXPORT int peek_rtcm3(const rtcm_t *rtcm, const uint8_t *frame, int len,
+                      rtcm_head_t *head);
+EXPORT int scan_rtcm3(gtime_t *time, const uint8_t *buff, size_t len,
+                      rtcm_index_t *index, int nmax, size_t *consumed);
+EXPORT gtime_t resolve_rtcm3(gtime_t time, int tsys, double tow);
+EXPORT void set_rtcm_type(rtcm_t *rtcm, int type1, int type2, int ena);
+EXPORT int set_rtcm_avx2(int ena);
+EXPORT int get_rtcm_class(int type);
+EXPORT uint32_t get_rtcm_count(const rtcm_t *rtcm, int type);
+EXPORT void init_rtcm_dedup(rtcm_dedup_t *dedup, double window);
+EXPORT void get_rtcm_dedup(rtcm_dedup_t *dedup, uint32_t *npass,
+                          uint32_t *ndup);
 
 #ifdef __cplusplus
 }
@@ -1,8 +1,14 @@
 package rtcm
 
 import (
+	"bytes"
 	"fmt"
+	"hash/crc32"
+	"math"
+	"math/rand"
 	"os"
+	"reflect"
+	"sync"
 	"testing"
 )
 
@@ -23,6 +29,8 @@ var (
 		1121, 1122, 1123, 1124, 1125, 1126, 1127,
 		1230,
 	}
+
+	frame1005 = []byte{211, 0, 19, 62, 208, 0, 3, 181, 150, 68, 101, 184, 134, 55, 187, 179, 82, 183, 116, 225, 229, 121, 76, 148, 146}
 )
 
 func TestCdecode(t *testing.T) {
@@ -75,6 +83,482 @@ func TestDecode(t *testing.T) {
 	}
 }
 
+func TestDecoder(t *testing.T) {
+	dec, err := NewDecoder()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dec.Close()
+
+	var stream []byte
+	for i := 0; i < 3; i++ {
+		stream = append(stream, 0x24, 0xd3, 0xff, 0xd3, 0x00, 0x01)
+		stream = append(stream, frame1005...)
+	}
+
+	var rtcms []Rtcm
+	for len(stream) > 0 {
+		n := 7
+		if n > len(stream) {
+			n = len(stream)
+		}
+		rtcms = append(rtcms, dec.Input(stream[:n])...)
+		stream = stream[n:]
+	}
+
+	if len(rtcms) != 3 {
+		t.Fatalf("expected to get %d messages, but got %d", 3, len(rtcms))
+	}
+	for _, rtcm := range rtcms {
+		if rtcm.Type != 1005 {
+			t.Fatalf("expected to get %d, but got %d", 1005, rtcm.Type)
+		}
+		if rtcm.Sta.Pos[0] != -4472357.5368 {
+			t.Fatalf("expected position x to %f, but got %f", -4472357.5368, rtcm.Sta.Pos[0])
+		}
+	}
+}
+
+func TestDecoderRecover(t *testing.T) {
+	dec, err := NewDecoder()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dec.Close()
+
+	// false preamble with length 64 covering the following frames
+	stream := []byte{0xd3, 0x00, 0x40, 0x12}
+	for i := 0; i < 3; i++ {
+		stream = append(stream, frame1005...)
+	}
+
+	rtcms := dec.Input(stream)
+	if len(rtcms) != 3 {
+		t.Fatalf("expected to get %d messages, but got %d", 3, len(rtcms))
+	}
+
+	stats := dec.Stats()
+	if stats.Recovered != 3 || stats.SkipBytes != 4 {
+		t.Fatalf("expected to get %d recovered and %d skipped, but got %d and %d", 3, 4, stats.Recovered, stats.SkipBytes)
+	}
+}
+
+func TestDecoderReject(t *testing.T) {
+	dec, err := NewDecoder()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dec.Close()
+
+	// truncated type 1005 and unsupported type 1036 with valid parity
+	stream := append([]byte{}, frame1005...)
+	stream = append(stream, makeFrame([][2]uint32{{1005, 12}, {0, 12}, {0, 32}})...)
+	stream = append(stream, makeFrame([][2]uint32{{1036, 12}, {0, 12}})...)
+	stream = append(stream, frame1005...)
+
+	rtcms := dec.Input(stream)
+	if len(rtcms) != 2 {
+		t.Fatalf("expected to get %d messages, but got %d", 2, len(rtcms))
+	}
+	if stats := dec.Stats(); stats.Rejected != 2 {
+		t.Fatalf("expected to get %d rejected, but got %d", 2, stats.Rejected)
+	}
+}
+
+func TestDecoderStatsTypes(t *testing.T) {
+	dec, err := NewDecoder()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dec.Close()
+
+	// message types of the three ranges of the message type index
+	var stream []byte
+	stream = append(stream, frame1005...)
+	stream = append(stream, frame1005...)
+	stream = append(stream, frame1004(1, 100000000)...)
+	stream = append(stream, makeFrame([][2]uint32{{4073, 12}, {0, 4}, {0, 8}})...)
+	stream = append(stream, frameRand(rand.New(rand.NewSource(1)), 63, 0)...)
+	dec.Input(stream)
+
+	want := map[int]int{1005: 2, 1004: 1, 4073: 1, 63: 1}
+	if got := dec.Stats().Types; !reflect.DeepEqual(got, want) {
+		t.Fatalf("expected to get types %v, but got %v", want, got)
+	}
+}
+
+func TestDecoderMixed(t *testing.T) {
+	// check value of crc-16 (CCITT) of the test frames
+	if crc := crc16([]byte("123456789")); crc != 0x31c3 {
+		t.Fatalf("expected to get crc-16 %04x, but got %04x", 0x31c3, crc)
+	}
+	// NMEA sentence and UBX, SBF and NovAtel frames with a false preamble in the payload
+	nmea := []byte("$GPGGA,000000.00,3521.0,S,14909.5,E,1,08,1.0,618.0,M,0.0,M,,*6A\r\n")
+	payload := []byte{0xd3, 0x00, 0x40, 0x12, 0x00, 0x00, 0x00, 0x00}
+	ubx := ubxFrame(0x01, 0x07, payload)
+	sbf := sbfFrame(4007, payload)
+	oem := novatelFrame(43, payload)
+	nforeign := len(nmea) + len(ubx) + len(sbf) + len(oem)
+
+	// frames split in the halves across inputs are buffered and tested after completed
+	var stream []byte
+	var halves [][]byte
+	for i := 0; i < 3; i++ {
+		for _, frame := range [][]byte{nmea, frame1005, ubx, sbf, oem} {
+			stream = append(stream, frame...)
+			halves = append(halves, frame[:len(frame)/2], frame[len(frame)/2:])
+		}
+	}
+	for _, inputs := range [][][]byte{{stream}, halves} {
+		dec, err := NewDecoder()
+		if err != nil {
+			t.Fatal(err)
+		}
+		defer dec.Close()
+		dec.SetMixed(true)
+
+		var rtcms []Rtcm
+		for _, data := range inputs {
+			rtcms = append(rtcms, dec.Input(data)...)
+		}
+		if len(rtcms) != 3 {
+			t.Fatalf("inputs %d: expected to get %d messages, but got %d", len(inputs), 3, len(rtcms))
+		}
+		stats := dec.Stats()
+		if stats.Foreign != 3*nforeign || stats.SkipBytes != 0 || stats.Recovered != 0 {
+			t.Fatalf("inputs %d: expected to get %d foreign and %d skipped, but got %d and %d", len(inputs), 3*nforeign, 0, stats.Foreign, stats.SkipBytes)
+		}
+	}
+}
+
+func TestDecoderMixedFalseFrame(t *testing.T) {
+	// false UBX header (72 bytes frame without checksum) followed by RTCM frames
+	var stream []byte
+	stream = append(stream, 0xb5, 0x62, 0x01, 0x07, 0x40, 0x00)
+	for i := 0; i < 3; i++ {
+		stream = append(stream, frame1005...)
+	}
+	for _, size := range []int{len(stream), 7} {
+		dec, err := NewDecoder()
+		if err != nil {
+			t.Fatal(err)
+		}
+		defer dec.Close()
+		dec.SetMixed(true)
+
+		var rtcms []Rtcm
+		for i := 0; i < len(stream); i += size {
+			j := i + size
+			if j > len(stream) {
+				j = len(stream)
+			}
+			rtcms = append(rtcms, dec.Input(stream[i:j])...)
+		}
+		if len(rtcms) != 3 {
+			t.Fatalf("size %d: expected to get %d messages, but got %d", size, 3, len(rtcms))
+		}
+		stats := dec.Stats()
+		if stats.Foreign != 0 || stats.SkipBytes != 6 {
+			t.Fatalf("size %d: expected to get %d foreign and %d skipped, but got %d and %d", size, 0, 6, stats.Foreign, stats.SkipBytes)
+		}
+	}
+}
+
+// ubxFrame build a UBX frame with 8-bit fletcher checksum
+func ubxFrame(class, id byte, payload []byte) []byte {
+	frame := []byte{0xb5, 0x62, class, id, byte(len(payload)), byte(len(payload) >> 8)}
+	frame = append(frame, payload...)
+	var cka, ckb byte
+	for _, b := range frame[2:] {
+		cka += b
+		ckb += cka
+	}
+	return append(frame, cka, ckb)
+}
+
+// sbfFrame build a SBF block with crc-16 (payload padded to 4 bytes)
+func sbfFrame(id uint16, payload []byte) []byte {
+	n := 8 + (len(payload)+3)/4*4
+	frame := make([]byte, n)
+	frame[0], frame[1] = '$', '@'
+	frame[4], frame[5] = byte(id), byte(id>>8)
+	frame[6], frame[7] = byte(n), byte(n>>8)
+	copy(frame[8:], payload)
+	crc := crc16(frame[4:])
+	frame[2], frame[3] = byte(crc), byte(crc>>8)
+	return frame
+}
+
+// novatelFrame build a NovAtel OEM binary frame (28 bytes header) with crc-32
+func novatelFrame(id uint16, payload []byte) []byte {
+	frame := make([]byte, 28, 28+len(payload)+4)
+	frame[0], frame[1], frame[2], frame[3] = 0xaa, 0x44, 0x12, 28
+	frame[4], frame[5] = byte(id), byte(id>>8)
+	frame[8], frame[9] = byte(len(payload)), byte(len(payload)>>8)
+	frame = append(frame, payload...)
+	crc := crc32novatel(frame)
+	return append(frame, byte(crc), byte(crc>>8), byte(crc>>16), byte(crc>>24))
+}
+
+// crc16 compute crc-16 (CCITT, initial value 0)
+func crc16(data []byte) (crc uint16) {
+	for _, b := range data {
+		crc ^= uint16(b) << 8
+		for j := 0; j < 8; j++ {
+			if crc&0x8000 != 0 {
+				crc = crc<<1 ^ 0x1021
+			} else {
+				crc <<= 1
+			}
+		}
+	}
+	return
+}
+
+// crc32novatel compute crc-32 of NovAtel (IEEE without inversion)
+func crc32novatel(data []byte) uint32 {
+	return ^crc32.Update(0xffffffff, crc32.IEEETable, data)
+}
+
+func TestDecoderRelay(t *testing.T) {
+	dec, err := NewDecoder()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dec.Close()
+
+	var stream []byte
+	for i := 0; i < 3; i++ {
+		stream = append(stream, 0x24, 0xd3, 0xff)
+		stream = append(stream, frame1005...)
+		stream = append(stream, frame1004obs(uint32(100000+i*1000), []uint32{1, 2}, []uint32{10, 10})...)
+	}
+
+	// frames split across inputs are copied
+	var frames []RelayFrame
+	for i := 0; i < len(stream); i += 40 {
+		j := i + 40
+		if j > len(stream) {
+			j = len(stream)
+		}
+		frames = append(frames, dec.Relay(stream[i:j])...)
+	}
+	if len(frames) != 6 {
+		t.Fatalf("expected to get %d frames, but got %d", 6, len(frames))
+	}
+	for i, f := range frames {
+		if i%2 == 0 && (f.Type != 1005 || f.StaId != 0 || !bytes.Equal(f.Data, frame1005)) {
+			t.Fatalf("frame %d: expected to get type %d", i, 1005)
+		}
+		if i%2 == 1 && (f.Type != 1004 || f.StaId != 1 || !CheckCrc(f.Data)) {
+			t.Fatalf("frame %d: expected to get type %d", i, 1004)
+		}
+	}
+	if dec.crtcm.obs.n != 0 || dec.crtcm.sta.pos[0] != 0 {
+		t.Fatalf("expected to keep decoding state")
+	}
+}
+
+func TestDecoderTypes(t *testing.T) {
+	dec, err := NewDecoder()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dec.Close()
+
+	stream := append([]byte{}, frame1005...)
+	stream = append(stream, frame1004obs(100000, []uint32{1, 2}, []uint32{10, 10})...)
+
+	dec.EnableTypes(1004)
+	if rtcms := dec.Input(stream); len(rtcms) != 1 || rtcms[0].Type != 1004 {
+		t.Fatalf("expected to get only type %d", 1004)
+	}
+	dec.EnableTypes()
+	dec.DisableTypes(1004)
+	if rtcms := dec.Input(stream); len(rtcms) != 1 || rtcms[0].Type != 1005 {
+		t.Fatalf("expected to get only type %d", 1005)
+	}
+	stats := dec.Stats()
+	if stats.Disabled != 2 {
+		t.Fatalf("expected to get %d disabled, but got %d", 2, stats.Disabled)
+	}
+	if stats.Types[1004] != 1 || stats.Types[1005] != 1 || len(stats.Types) != 2 {
+		t.Fatalf("expected to count one frame of each type, but got %v", stats.Types)
+	}
+}
+
+func TestDecoderDedup(t *testing.T) {
+	dedup, err := NewDedup(5.0)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dedup.Close()
+
+	var decs [2]*Decoder
+	for i := range decs {
+		if decs[i], err = NewDecoder(); err != nil {
+			t.Fatal(err)
+		}
+		defer decs[i].Close()
+		decs[i].SetDedup(dedup)
+	}
+
+	// redundant streams of 1 Hz epochs, the second lagging by 2 epochs
+	var epochs [][]byte
+	for i := 0; i < 10; i++ {
+		epochs = append(epochs, frame1004obs(uint32(100000+i*1000), []uint32{1, 2}, []uint32{10, 10}))
+	}
+	var n [2]int
+	for i := 0; i < len(epochs)+2; i++ {
+		if i < len(epochs) {
+			n[0] += len(decs[0].Input(epochs[i]))
+		}
+		if i >= 2 {
+			n[1] += len(decs[1].Input(epochs[i-2]))
+		}
+	}
+	if n[0] != len(epochs) || n[1] != 0 {
+		t.Fatalf("expected to get %d and %d messages, but got %d and %d", len(epochs), 0, n[0], n[1])
+	}
+	if stats := dedup.Stats(); stats.Passed != len(epochs) || stats.Dropped != len(epochs) {
+		t.Fatalf("expected to get %d passed and %d dropped, but got %d and %d", len(epochs), len(epochs), stats.Passed, stats.Dropped)
+	}
+
+	// duplicate frame out of the window is decoded again
+	if rtcms := decs[1].Input(epochs[0]); len(rtcms) != 1 {
+		t.Fatalf("expected to get %d messages, but got %d", 1, len(rtcms))
+	}
+}
+
+func TestDecoderDedupMasked(t *testing.T) {
+	dedup, err := NewDedup(5.0)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dedup.Close()
+
+	var decs [2]*Decoder
+	for i := range decs {
+		if decs[i], err = NewDecoder(); err != nil {
+			t.Fatal(err)
+		}
+		defer decs[i].Close()
+		decs[i].SetDedup(dedup)
+	}
+	// frames of disabled type in the first stream do not drop the second
+	decs[0].DisableTypes(1004)
+
+	var n [2]int
+	for i := 0; i < 10; i++ {
+		epoch := frame1004obs(uint32(100000+i*1000), []uint32{1, 2}, []uint32{10, 10})
+		n[0] += len(decs[0].Input(epoch))
+		n[1] += len(decs[1].Input(epoch))
+	}
+	if n[0] != 0 || n[1] != 10 {
+		t.Fatalf("expected to get %d and %d messages, but got %d and %d", 0, 10, n[0], n[1])
+	}
+	if stats := decs[0].Stats(); stats.Disabled != 10 {
+		t.Fatalf("expected to get %d disabled, but got %d", 10, stats.Disabled)
+	}
+	if stats := dedup.Stats(); stats.Passed != 10 || stats.Dropped != 0 {
+		t.Fatalf("expected to get %d passed and %d dropped, but got %d and %d", 10, 0, stats.Passed, stats.Dropped)
+	}
+
+	// relayed frames are masked before the filter as well
+	if frames := decs[0].Relay(frame1004obs(200000, []uint32{1}, []uint32{10})); len(frames) != 0 {
+		t.Fatalf("expected to get %d frames, but got %d", 0, len(frames))
+	}
+	if frames := decs[1].Relay(frame1004obs(200000, []uint32{1}, []uint32{10})); len(frames) != 1 {
+		t.Fatalf("expected to get %d frames, but got %d", 1, len(frames))
+	}
+}
+
+func TestDecoderDedupParallel(t *testing.T) {
+	// time window over the log for the streams decoded at any pace
+	dedup, err := NewDedup(2000.0)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dedup.Close()
+
+	// redundant streams decoded on two goroutines
+	var log []byte
+	for i := 0; i < 1000; i++ {
+		log = append(log, frame1004obs(uint32(100000+i*1000), []uint32{1, 2}, []uint32{10, 10})...)
+	}
+	var times [2]map[GtimeT]bool
+	var wg sync.WaitGroup
+	for i := range times {
+		dec, err := NewDecoder()
+		if err != nil {
+			t.Fatal(err)
+		}
+		defer dec.Close()
+		dec.SetDedup(dedup)
+		times[i] = map[GtimeT]bool{}
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			for data := log; len(data) > 0; {
+				m := 100
+				if m > len(data) {
+					m = len(data)
+				}
+				for _, rtcm := range dec.Input(data[:m]) {
+					times[i][rtcm.Time] = true
+				}
+				data = data[m:]
+			}
+		}(i)
+	}
+	wg.Wait()
+
+	// each epoch passed by either stream, duplicates over the slots of the
+	// filter passed by both
+	n := len(times[0]) + len(times[1])
+	for time := range times[1] {
+		times[0][time] = true
+	}
+	if len(times[0]) != 1000 {
+		t.Fatalf("expected to get %d epochs, but got %d", 1000, len(times[0]))
+	}
+	stats := dedup.Stats()
+	if stats.Passed != n || stats.Passed+stats.Dropped != 2000 || stats.Dropped < 900 {
+		t.Fatalf("expected to get %d passed and %d dropped, but got %d and %d", n, 2000-n, stats.Passed, stats.Dropped)
+	}
+}
+
+func TestDecodeFrame(t *testing.T) {
+	rtcm, err := Decode(frame1005)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if rtcm.Type != 1005 || rtcm.Sta.Pos[0] != -4472357.5368 {
+		t.Fatalf("expected to get type %d, but got %d", 1005, rtcm.Type)
+	}
+
+	frame := append([]byte{}, frame1005...)
+	frame[len(frame)-1] ^= 0x01
+	if _, err = Decode(frame); err == nil {
+		t.Fatalf("expected to get error for parity error frame")
+	}
+}
+
+func TestPeek(t *testing.T) {
+	head, err := Peek(frame1005)
+	if err != nil {
+		t.Fatal(err)
+	}
+	rtcm, _ := Decode(frame1005)
+	if head.Type != rtcm.Type || head.StaId != rtcm.StaId || head.Time.Time != 0 {
+		t.Fatalf("expected to get type %d staid %d, but got %d %d", rtcm.Type, rtcm.StaId, head.Type, head.StaId)
+	}
+
+	if _, err = Peek(frame1005[:len(frame1005)-1]); err != ErrInvalid {
+		t.Fatalf("expected to get %v, but got %v", ErrInvalid, err)
+	}
+}
+
 func TestCheckCrc(t *testing.T) {
 	for _, msgType := range msgs {
 		msgType := msgType
@@ -93,6 +577,628 @@ func TestCheckCrc(t *testing.T) {
 	}
 }
 
+// crc24q bitwise crc-24q as reference
+func crc24q(data []byte) uint32 {
+	var crc uint32
+	for _, b := range data {
+		crc ^= uint32(b) << 16
+		for i := 0; i < 8; i++ {
+			crc <<= 1
+			if crc&0x1000000 != 0 {
+				crc ^= 0x1864CFB
+			}
+		}
+	}
+	return crc & 0xFFFFFF
+}
+
+func TestCheckCrcLength(t *testing.T) {
+	rnd := rand.New(rand.NewSource(1))
+	for n := 0; n <= 1100; n++ {
+		data := make([]byte, n+3)
+		rnd.Read(data[:n])
+		crc := crc24q(data[:n])
+		data[n], data[n+1], data[n+2] = byte(crc>>16), byte(crc>>8), byte(crc)
+
+		if n >= 3 && !CheckCrc(data) {
+			t.Fatalf("expected crc of %d bytes to be valid", n)
+		}
+		if n >= 3 {
+			data[rnd.Intn(n)] ^= 1 << uint(rnd.Intn(8))
+			if CheckCrc(data) {
+				t.Fatalf("expected crc of %d bytes with bit error to be invalid", n)
+			}
+		}
+	}
+}
+
+func TestCheckCrcs(t *testing.T) {
+	rnd := rand.New(rand.NewSource(1))
+	var data []byte
+	offsets := []int{0}
+	for i := 0; i < 10000; i++ {
+		n := rnd.Intn(300)
+		frame := make([]byte, n+3)
+		rnd.Read(frame[:n])
+		crc := crc24q(frame[:n])
+		frame[n], frame[n+1], frame[n+2] = byte(crc>>16), byte(crc>>8), byte(crc)
+		if n > 0 && rnd.Intn(3) == 0 {
+			frame[rnd.Intn(n)] ^= 1 << uint(rnd.Intn(8))
+		}
+		data = append(data, frame...)
+		offsets = append(offsets, len(data))
+	}
+
+	valid, nvalid := CheckCrcs(data, offsets)
+	count := 0
+	for i := 0; i < len(offsets)-1; i++ {
+		want := CheckCrc(data[offsets[i]:offsets[i+1]])
+		if valid.Valid(i) != want {
+			t.Fatalf("frame %d: expected to get %v, but got %v", i, want, valid.Valid(i))
+		}
+		if want {
+			count++
+		}
+	}
+	if nvalid != count {
+		t.Fatalf("expected to get %d valid, but got %d", count, nvalid)
+	}
+}
+
+func TestCheckCrcsOffsets(t *testing.T) {
+	data := append(append([]byte{}, frame1005...), frame1005...)
+	n := len(frame1005)
+	if _, nvalid := CheckCrcs(data, []int{0, n, 2 * n}); nvalid != 2 {
+		t.Fatalf("expected to get %d valid, but got %d", 2, nvalid)
+	}
+	for _, offsets := range [][]int{{-1, n}, {0, 2*n + 1}, {n, 0}, {0, n, n - 1}} {
+		func() {
+			defer func() {
+				if recover() == nil {
+					t.Fatalf("offsets %v: expected to panic", offsets)
+				}
+			}()
+			CheckCrcs(data, offsets)
+		}()
+	}
+}
+
+// getbituBit bit-by-bit getbitu as reference
+func getbituBit(buff []byte, pos, n int) uint32 {
+	var bits uint32
+	for i := pos; i < pos+n; i++ {
+		bits = bits<<1 + uint32(buff[i/8]>>uint(7-i%8)&1)
+	}
+	return bits
+}
+
+func TestGetbitu(t *testing.T) {
+	rnd := rand.New(rand.NewSource(1))
+	for k := 0; k < 64; k++ {
+		buff := make([]byte, 16)
+		switch k {
+		case 0:
+		case 1:
+			for i := range buff {
+				buff[i] = 0xff
+			}
+		default:
+			rnd.Read(buff)
+		}
+		for n := 0; n <= 32; n++ {
+			// fields up to the end of buffer
+			for pos := 0; pos+n <= len(buff)*8; pos++ {
+				want := getbituBit(buff, pos, n)
+				if got := getbitu(buff[:(pos+n+7)/8], pos, n); got != want {
+					t.Fatalf("getbitu(pos=%d,len=%d): expected %08x, but got %08x", pos, n, want, got)
+				}
+				swant := int32(want)
+				if n > 0 && n < 32 && want>>uint(n-1)&1 != 0 {
+					swant = int32(want | ^uint32(0)<<uint(n))
+				}
+				if got := getbits(buff, pos, n); got != swant {
+					t.Fatalf("getbits(pos=%d,len=%d): expected %d, but got %d", pos, n, swant, got)
+				}
+			}
+		}
+	}
+}
+
+func TestCodePris(t *testing.T) {
+	opts := []string{"", "-GL1C", "-GL1P -GL1C -EL5X", "-GL2", "-RL1P-RL2C", "-CL2I -CL7Q -JL1X", "-IL5A -SL1C"}
+	for _, opt := range opts {
+		for _, sys := range []int{0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40} {
+			for code, pri := range codepris(sys, opt) {
+				if want := codepri(sys, code, opt); pri != want {
+					t.Fatalf("sys=%d code=%d opt=%q: expected priority %d, but got %d", sys, code, opt, want, pri)
+				}
+			}
+		}
+	}
+}
+
+func TestObs2code(t *testing.T) {
+	for code := 1; code2obs(code) != ""; code++ {
+		if got := obs2code(code2obs(code)); got != code {
+			t.Fatalf("obs2code(%q): expected %d, but got %d", code2obs(code), code, got)
+		}
+	}
+	for _, obs := range []string{"", "1", "1c", "0C", "1CX", "3A", "9Z"} {
+		if got := obs2code(obs); got != 0 {
+			t.Fatalf("obs2code(%q): expected %d, but got %d", obs, 0, got)
+		}
+	}
+}
+
+// frameMSM generate a MSM frame of the type with the satellites and the
+// signals of all cells, fields are the satellite data and the signal data
+// fields {bits, values of the satellites or the cells}
+func frameMSM(typ int, epoch uint32, sats, sigs []uint32, fields [][]uint32) []byte {
+	var satmask [2]uint32
+	for _, sat := range sats {
+		satmask[(sat-1)/32] |= 1 << (31 - (sat-1)%32)
+	}
+	var sigmask uint32
+	for _, sig := range sigs {
+		sigmask |= 1 << (32 - sig)
+	}
+	f := [][2]uint32{
+		{uint32(typ), 12}, {1, 12}, {epoch, 30}, {0, 1}, {0, 3}, {0, 7}, {0, 2},
+		{0, 2}, {0, 1}, {0, 3}, {satmask[0], 32}, {satmask[1], 32}, {sigmask, 32},
+	}
+	for range sats {
+		f = append(f, [2]uint32{1<<len(sigs) - 1, uint32(len(sigs))})
+	}
+	for _, field := range fields {
+		for _, v := range field[1:] {
+			f = append(f, [2]uint32{v, field[0]})
+		}
+	}
+	return makeFrame(f)
+}
+
+// msmFieldBits bit lengths of satellite and signal fields of MSM 4-7
+var msmFieldBits = map[int][2][]uint32{
+	4: {{8, 10}, {15, 22, 4, 1, 6}},
+	5: {{8, 4, 10, 14}, {15, 22, 4, 1, 6, 15}},
+	6: {{8, 10}, {20, 24, 10, 1, 10}},
+	7: {{8, 4, 10, 14}, {20, 24, 10, 1, 10, 15}},
+}
+
+// frameMSMRand build an MSM 4-7 frame with random masks and fields of the
+// satellites up to maxsat
+func frameMSMRand(r *rand.Rand, typ int, epoch uint32, maxsat int) []byte {
+	sats := r.Perm(maxsat)[:8+r.Intn(9)]
+	sigs := r.Perm(32)[:1+r.Intn(4)]
+
+	var satmask [2]uint32
+	for _, sat := range sats {
+		satmask[sat/32] |= 1 << (31 - sat%32)
+	}
+	var sigmask uint32
+	for _, sig := range sigs {
+		sigmask |= 1 << (31 - sig)
+	}
+	f := [][2]uint32{
+		{uint32(typ), 12}, {1, 12}, {epoch, 30}, {0, 1}, {0, 3}, {0, 7}, {0, 2},
+		{0, 2}, {0, 1}, {0, 3}, {satmask[0], 32}, {satmask[1], 32}, {sigmask, 32},
+	}
+	ncell := 0
+	for range sats {
+		mask := r.Uint32() & (1<<len(sigs) - 1)
+		for i := range sigs {
+			ncell += int(mask >> i & 1)
+		}
+		f = append(f, [2]uint32{mask, uint32(len(sigs))})
+	}
+	bits := msmFieldBits[typ%10]
+	for _, n := range bits[0] {
+		for range sats {
+			f = append(f, [2]uint32{r.Uint32() & (1<<n - 1), n})
+		}
+	}
+	for _, n := range bits[1] {
+		for i := 0; i < ncell; i++ {
+			f = append(f, [2]uint32{r.Uint32() & (1<<n - 1), n})
+		}
+	}
+	return makeFrame(f)
+}
+
+func TestMsmAvx2(t *testing.T) {
+	defer setAvx2(true)
+	if !setAvx2(true) {
+		t.Skip("no avx2 support")
+	}
+	// random MSM 4-7 frames of all systems including invalid fields
+	r := rand.New(rand.NewSource(1))
+	var stream []byte
+	for i := 0; i < 50; i++ {
+		for sys := 1070; sys <= 1130; sys += 10 {
+			for msm := 4; msm <= 7; msm++ {
+				stream = append(stream, frameMSMRand(r, sys+msm, uint32(50000000+i*1000), 64)...)
+			}
+		}
+	}
+	var rtcms [2][]Rtcm
+	for i, avx2 := range []bool{true, false} {
+		setAvx2(avx2)
+		dec, err := NewDecoder()
+		if err != nil {
+			t.Fatal(err)
+		}
+		defer dec.Close()
+		rtcms[i] = dec.Input(stream)
+	}
+	if len(rtcms[0]) != 50*7*4 || len(rtcms[1]) != len(rtcms[0]) {
+		t.Fatalf("expected to get %d messages, but got %d and %d", 50*7*4, len(rtcms[0]), len(rtcms[1]))
+	}
+	for i := range rtcms[0] {
+		if !reflect.DeepEqual(rtcms[0][i].Obs, rtcms[1][i].Obs) {
+			t.Fatalf("message %d (type %d): expected to get the same obs by avx2 and scalar", i, rtcms[0][i].Type)
+		}
+	}
+}
+
+func TestMsmSigGal(t *testing.T) {
+	// Galileo MSM4 with the signals 1C and 8I (no obs code)
+	frame := frameMSM(1094, 100000000, []uint32{1}, []uint32{2, 18}, [][]uint32{
+		{8, 70}, {10, 0}, {15, 100, 100}, {22, 200, 200}, {4, 5, 5}, {1, 0, 0}, {6, 40, 40},
+	})
+	dec, err := NewDecoder()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dec.Close()
+	rtcms := dec.Input(frame)
+	if len(rtcms) != 1 {
+		t.Fatalf("expected to get %d message, but got %d", 1, len(rtcms))
+	}
+	if want := "L1C,(18)"; dec.msmTypes()[2] != want {
+		t.Fatalf("expected to get signal types %q, but got %q", want, dec.msmTypes()[2])
+	}
+	rtcm := rtcms[0]
+	if rtcm.Obs.N != 1 {
+		t.Fatalf("expected to get %d observation, but got %d", 1, rtcm.Obs.N)
+	}
+	for i, code := range rtcm.Obs.Data[0].Code {
+		want := 0
+		if i == 0 {
+			want = obs2code("1C")
+		}
+		if int(code) != want {
+			t.Fatalf("code[%d]: expected %d, but got %d", i, want, code)
+		}
+	}
+}
+
+func TestMsmSigCache(t *testing.T) {
+	const rangeMs = 299792458.0 * 0.001
+	const p2_29 = 1.0 / (1 << 29)
+	freqs := map[string]float64{"1C": 1.57542e9, "1W": 1.57542e9, "2L": 1.22760e9, "5Q": 1.17645e9}
+
+	// GPS MSM4 frames of a satellite with the options (-GL1W: 1W only on L1),
+	// the code priorities of L1 and the signals changed between the frames,
+	// codes and phaseranges by the obs data index (L1,L2,L5)
+	const pri = "CPYWMNSL"
+	defer setcodepri(0x01, 0, pri)
+	cases := []struct {
+		opt   string
+		pri   string
+		sigs  []uint32
+		types string
+		codes [3]string
+		cps   [3]float64
+	}{
+		{"", pri, []uint32{2, 4}, "L1C,L1W", [3]string{"1C", "", ""}, [3]float64{1000, 0, 0}},
+		{"-GL1W", pri, []uint32{2, 4}, "L1C,L1W", [3]string{"1W", "", ""}, [3]float64{2000, 0, 0}},
+		{"-GL1W", pri, []uint32{2, 16}, "L1C,L2L", [3]string{"", "2L", ""}, [3]float64{0, 2000, 0}},
+		{"", pri, []uint32{2, 16}, "L1C,L2L", [3]string{"1C", "2L", ""}, [3]float64{1000, 2000, 0}},
+		{"-GL1W", pri, []uint32{16, 23}, "L2L,L5Q", [3]string{"", "2L", "5Q"}, [3]float64{0, 1000, 2000}},
+		{"", "WCPYMNSL", []uint32{2, 4}, "L1C,L1W", [3]string{"1W", "", ""}, [3]float64{2000, 0, 0}},
+		{"", pri, []uint32{2, 4}, "L1C,L1W", [3]string{"1C", "", ""}, [3]float64{1000, 0, 0}},
+	}
+	dec, err := NewDecoder()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dec.Close()
+
+	for i, c := range cases {
+		dec.setOpt(c.opt)
+		setcodepri(0x01, 0, c.pri)
+		// phaserange 1000 and 2000 of the signals
+		frame := frameMSM(1074, uint32(100000000+i*1000), []uint32{1}, c.sigs, [][]uint32{
+			{8, 70}, {10, 0}, {15, 0, 0}, {22, 1000, 2000}, {4, 0, 0}, {1, 0, 0}, {6, 40, 40},
+		})
+		rtcms := dec.Input(frame)
+		if len(rtcms) != 1 || rtcms[0].Obs.N != 1 {
+			t.Fatalf("case %d: expected to get %d message with %d observation", i, 1, 1)
+		}
+		if got := dec.msmTypes()[0]; got != c.types {
+			t.Fatalf("case %d: expected to get signal types %q, but got %q", i, c.types, got)
+		}
+		data := rtcms[0].Obs.Data[0]
+		for k, obs := range c.codes {
+			if int(data.Code[k]) != obs2code(obs) {
+				t.Fatalf("case %d: code[%d]: expected %q, but got %q", i, k, obs, code2obs(int(data.Code[k])))
+			}
+			if obs == "" {
+				continue
+			}
+			want := (70 + c.cps[k]*p2_29) * rangeMs * freqs[obs] / 299792458.0
+			if math.Abs(data.L[k]-want) > 1e-6 {
+				t.Fatalf("case %d: L[%d]: expected %.6f, but got %.6f", i, k, want, data.L[k])
+			}
+		}
+	}
+}
+
+// msmObs expected obs data of a satellite in MSM (0: no obs)
+type msmObs struct {
+	sat  uint8
+	P, L [2]float64
+	D    [2]float32
+	SNR  [2]uint16
+	LLI  [2]uint8
+	code [2]string
+}
+
+// twos two's complement of the signed value in n bits
+func twos(v int32, n uint) uint32 {
+	return uint32(v) & (1<<n - 1)
+}
+
+// checkMsmObs check the obs data of the signals 0 and 1 decoded from MSM
+func checkMsmObs(t *testing.T, obs ObsT, wants []msmObs) {
+	t.Helper()
+	if obs.N != len(wants) {
+		t.Fatalf("expected to get %d observations, but got %d", len(wants), obs.N)
+	}
+	near := func(a, b float64) bool { return math.Abs(a-b) <= 1e-6*math.Max(1, math.Abs(b)) }
+	for i, want := range wants {
+		got := obs.Data[i]
+		if got.Sat != want.sat {
+			t.Fatalf("obs %d: expected sat %d, but got %d", i, want.sat, got.Sat)
+		}
+		for k := 0; k < 2; k++ {
+			if !near(got.P[k], want.P[k]) || !near(got.L[k], want.L[k]) ||
+				!near(float64(got.D[k]), float64(want.D[k])) {
+				t.Fatalf("sat %d signal %d: expected P=%.6f L=%.6f D=%.4f, but got P=%.6f L=%.6f D=%.4f",
+					want.sat, k, want.P[k], want.L[k], want.D[k], got.P[k], got.L[k], got.D[k])
+			}
+			if got.SNR[k] != want.SNR[k] || got.LLI[k] != want.LLI[k] || int(got.Code[k]) != obs2code(want.code[k]) {
+				t.Fatalf("sat %d signal %d: expected SNR=%d LLI=%d code=%s, but got SNR=%d LLI=%d code=%s",
+					want.sat, k, want.SNR[k], want.LLI[k], want.code[k], got.SNR[k], got.LLI[k], code2obs(int(got.Code[k])))
+			}
+		}
+	}
+}
+
+func TestMsm4Obs(t *testing.T) {
+	const rangeMs = 299792458.0 * 0.001
+	const p2_10, p2_24, p2_29 = 1.0 / (1 << 10), 1.0 / (1 << 24), 1.0 / (1 << 29)
+	const f1, f2 = 1.57542e9, 1.22760e9
+
+	// GPS MSM4 of the signals 1C and 2L: sat 2 without rough range (255),
+	// sat 3 with invalid pseudorange of 1C and phaserange of 2L
+	frame := frameMSM(1074, 100000000, []uint32{1, 2, 3}, []uint32{2, 16}, [][]uint32{
+		{8, 70, 255, 75},
+		{10, 512, 100, 1023},
+		{15, 1000, twos(-1000, 15), 500, 600, twos(-16384, 15), 700},
+		{22, 2000, twos(-2000, 22), 1500, 1600, 1700, twos(-2097152, 22)},
+		{4, 0, 5, 1, 2, 3, 4},
+		{1, 0, 1, 0, 0, 1, 0},
+		{6, 40, 35, 41, 36, 42, 37},
+	})
+	dec, err := NewDecoder()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dec.Close()
+	rtcms := dec.Input(frame)
+	if len(rtcms) != 1 {
+		t.Fatalf("expected to get %d message, but got %d", 1, len(rtcms))
+	}
+	r1 := (70 + 512*p2_10) * rangeMs
+	r3 := (75 + 1023*p2_10) * rangeMs
+	checkMsmObs(t, rtcms[0].Obs, []msmObs{
+		{
+			sat: 1,
+			P:   [2]float64{r1 + 1000*p2_24*rangeMs, r1 - 1000*p2_24*rangeMs},
+			L:   [2]float64{(r1 + 2000*p2_29*rangeMs) * f1 / 299792458.0, (r1 - 2000*p2_29*rangeMs) * f2 / 299792458.0},
+			SNR: [2]uint16{40000, 35000}, LLI: [2]uint8{1, 3}, code: [2]string{"1C", "2L"},
+		},
+		{
+			sat: 2,
+			SNR: [2]uint16{41000, 36000}, LLI: [2]uint8{0, 0}, code: [2]string{"1C", "2L"},
+		},
+		{
+			sat: 3,
+			P:   [2]float64{0, r3 + 700*p2_24*rangeMs},
+			L:   [2]float64{(r3 + 1700*p2_29*rangeMs) * f1 / 299792458.0, 0},
+			SNR: [2]uint16{42000, 37000}, LLI: [2]uint8{3, 0}, code: [2]string{"1C", "2L"},
+		},
+	})
+}
+
+func TestMsm7Obs(t *testing.T) {
+	const clight = 299792458.0
+	const rangeMs = clight * 0.001
+	const p2_10, p2_29, p2_31 = 1.0 / (1 << 10), 1.0 / (1 << 29), 1.0 / (1 << 31)
+	f1 := func(fcn float64) float64 { return 1.602e9 + fcn*0.5625e6 }
+	f2 := func(fcn float64) float64 { return 1.246e9 + fcn*0.4375e6 }
+
+	// GLONASS MSM7 of the signals 1C and 2C: sat 1 with fcn +1 and invalid
+	// phaserangerate of 2C, sat 2 with fcn -7, invalid rough phaserangerate,
+	// pseudorange of 1C and phaserange of 2C, sat 3 without fcn (15)
+	frame := frameMSM(1087, 3600000, []uint32{1, 2, 3}, []uint32{2, 8}, [][]uint32{
+		{8, 70, 71, 72},
+		{4, 8, 0, 15},
+		{10, 256, 0, 768},
+		{14, 100, twos(-8192, 14), twos(-200, 14)},
+		{20, 1000, twos(-1000, 20), twos(-524288, 20), 2000, 3000, 4000},
+		{24, 5000, twos(-5000, 24), 3000, twos(-8388608, 24), 6000, 7000},
+		{10, 0, 100, 200, 300, 400, 500},
+		{1, 0, 1, 0, 0, 0, 0},
+		{10, 650, 600, 640, 630, 620, 610},
+		{15, 50, twos(-16384, 15), 100, 200, twos(-300, 15), 400},
+	})
+	dec, err := NewDecoder()
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dec.Close()
+	rtcms := dec.Input(frame)
+	if len(rtcms) != 1 {
+		t.Fatalf("expected to get %d message, but got %d", 1, len(rtcms))
+	}
+	r1 := (70 + 256*p2_10) * rangeMs
+	r2 := 71 * rangeMs
+	r3 := (72 + 768*p2_10) * rangeMs
+	checkMsmObs(t, rtcms[0].Obs, []msmObs{
+		{
+			sat: 33,
+			P:   [2]float64{r1 + 1000*p2_29*rangeMs, r1 - 1000*p2_29*rangeMs},
+			L:   [2]float64{(r1 + 5000*p2_31*rangeMs) * f1(1) / clight, (r1 - 5000*p2_31*rangeMs) * f2(1) / clight},
+			D:   [2]float32{float32(-(100 + 50*0.0001) * f1(1) / clight), 0},
+			SNR: [2]uint16{40625, 37500}, LLI: [2]uint8{1, 3}, code: [2]string{"1C", "2C"},
+		},
+		{
+			sat: 34,
+			P:   [2]float64{0, r2 + 2000*p2_29*rangeMs},
+			L:   [2]float64{(r2 + 3000*p2_31*rangeMs) * f1(-7) / clight, 0},
+			D:   [2]float32{float32(-100 * 0.0001 * f1(-7) / clight), float32(-200 * 0.0001 * f2(-7) / clight)},
+			SNR: [2]uint16{40000, 39375}, LLI: [2]uint8{0, 0}, code: [2]string{"1C", "2C"},
+		},
+		{
+			sat: 35,
+			P:   [2]float64{r3 + 3000*p2_29*rangeMs, r3 + 4000*p2_29*rangeMs},
+			SNR: [2]uint16{38750, 38125}, LLI: [2]uint8{0, 0}, code: [2]string{"1C", "2C"},
+		},
+	})
+}
+
+func TestCode2freq(t *testing.T) {
+	cases := []struct {
+		sys  int
+		obs  string
+		fcn  int
+		freq float64
+	}{
+		{0x01, "1C", 0, 1.57542e9},
+		{0x01, "7Q", 0, 0},
+		{0x04, "1C", -7, 1.602e9 - 7*0.5625e6},
+		{0x04, "2P", 6, 1.246e9 + 6*0.4375e6},
+		{0x04, "3I", 0, 1.202025e9},
+		{0x04, "1C", 7, 0},
+		{0x20, "2I", 0, 1.561098e9},
+		{0x20, "7I", 0, 1.20714e9},
+		{0x40, "9A", 0, 2.492028e9},
+	}
+	for _, c := range cases {
+		if got := code2freq(c.sys, obs2code(c.obs), c.fcn); got != c.freq {
+			t.Fatalf("code2freq(sys=%d,%s,fcn=%d): expected %.0f, but got %.0f", c.sys, c.obs, c.fcn, c.freq, got)
+		}
+		if got := code2freqRef(c.sys, obs2code(c.obs), c.fcn); got != c.freq {
+			t.Fatalf("code2freqRef(sys=%d,%s,fcn=%d): expected %.0f, but got %.0f", c.sys, c.obs, c.fcn, c.freq, got)
+		}
+	}
+	// all systems (with none and LEO), codes (with out of range) and fcns
+	for _, sys := range []int{0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80} {
+		for code := 0; code <= 70; code++ {
+			for fcn := -9; fcn <= 8; fcn++ {
+				if got, want := code2freq(sys, code, fcn), code2freqRef(sys, code, fcn); got != want {
+					t.Fatalf("code2freq(sys=%d,code=%d(%s),fcn=%d): expected %.0f, but got %.0f",
+						sys, code, code2obs(code), fcn, want, got)
+				}
+			}
+		}
+	}
+}
+
+// code2freqRef reference of code2freq by the frequency band of obs code
+// (RINEX 3.04) per system
+func code2freqRef(sys, code, fcn int) float64 {
+	obs := code2obs(code)
+	if obs == "" {
+		return 0
+	}
+	band := obs[0]
+	switch sys {
+	case 0x01, 0x10: // GPS, QZSS
+		switch {
+		case band == '1':
+			return 1.57542e9
+		case band == '2':
+			return 1.22760e9
+		case band == '5':
+			return 1.17645e9
+		case band == '6' && sys == 0x10:
+			return 1.27875e9
+		}
+	case 0x02: // SBAS
+		switch band {
+		case '1':
+			return 1.57542e9
+		case '5':
+			return 1.17645e9
+		}
+	case 0x04: // GLONASS
+		if fcn < -7 || fcn > 6 {
+			return 0
+		}
+		switch band {
+		case '1':
+			return 1.60200e9 + 0.56250e6*float64(fcn)
+		case '2':
+			return 1.24600e9 + 0.43750e6*float64(fcn)
+		case '3':
+			return 1.202025e9
+		case '4':
+			return 1.600995e9
+		case '6':
+			return 1.248060e9
+		}
+	case 0x08: // Galileo
+		switch band {
+		case '1':
+			return 1.57542e9
+		case '5':
+			return 1.17645e9
+		case '6':
+			return 1.27875e9
+		case '7':
+			return 1.20714e9
+		case '8':
+			return 1.191795e9
+		}
+	case 0x20: // BDS
+		switch band {
+		case '1':
+			return 1.57542e9
+		case '2':
+			return 1.561098e9
+		case '5':
+			return 1.17645e9
+		case '6':
+			return 1.26852e9
+		case '7':
+			return 1.20714e9
+		case '8':
+			return 1.191795e9
+		}
+	case 0x40: // NavIC
+		switch band {
+		case '5':
+			return 1.17645e9
+		case '9':
+			return 2.492028e9
+		}
+	}
+	return 0
+}
+
 func TestEcefToLla(t *testing.T) {
 	ecef := [3]float64{-4472357.536800, 2670485.179400, -3669374.426300}
 	lla := EcefToLla(ecef)
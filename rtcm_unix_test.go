@@ -0,0 +1,56 @@
+//go:build unix
+
+package rtcm
+
+import (
+	"strings"
+	"syscall"
+	"testing"
+)
+
+// guardedCopy copy the data to the end of a page followed by an inaccessible
+// page, so a read past the end of the data faults
+func guardedCopy(t *testing.T, data []byte) []byte {
+	size := syscall.Getpagesize()
+	mem, err := syscall.Mmap(-1, 0, 2*size, syscall.PROT_READ|syscall.PROT_WRITE, syscall.MAP_ANON|syscall.MAP_PRIVATE)
+	if err != nil {
+		t.Fatal(err)
+	}
+	t.Cleanup(func() { syscall.Munmap(mem) })
+	if err := syscall.Mprotect(mem[size:], syscall.PROT_NONE); err != nil {
+		t.Fatal(err)
+	}
+	buf := mem[size-len(data) : size : size]
+	copy(buf, data)
+	return buf
+}
+
+func TestDecodeOverDeclared(t *testing.T) {
+	frames := map[string][]byte{
+		// 1008 with 255 bytes antenna descriptor declared in 6 bytes message
+		"1008": makeFrame([][2]uint32{{1008, 12}, {1, 12}, {255, 8}, {0, 16}}),
+		// 1033 with 255 bytes antenna descriptor declared
+		"1033 des": makeFrame([][2]uint32{{1033, 12}, {1, 12}, {255, 8}, {0, 8}, {0, 8}, {0, 8}, {0, 16}}),
+		// 1033 with 200 bytes receiver type declared
+		"1033 rec": makeFrame([][2]uint32{{1033, 12}, {1, 12}, {0, 8}, {0, 8}, {0, 8}, {200, 8}, {0, 16}}),
+	}
+	for name, frame := range frames {
+		if _, err := Decode(guardedCopy(t, frame)); err == nil {
+			t.Fatalf("%s: expected to get error for over-declared length", name)
+		}
+	}
+
+	// descriptor longer than the station struct strings
+	fields := [][2]uint32{{1008, 12}, {1, 12}, {100, 8}}
+	for i := 0; i < 100; i++ {
+		fields = append(fields, [2]uint32{'A', 8})
+	}
+	fields = append(fields, [2]uint32{0, 8}, [2]uint32{0, 8})
+	rtcm, err := Decode(guardedCopy(t, makeFrame(fields)))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if want := strings.Repeat("A", 31); rtcm.Sta.Antdes != want {
+		t.Fatalf("expected to get antenna descriptor %q, but got %q", want, rtcm.Sta.Antdes)
+	}
+}
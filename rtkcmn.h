@@ -19,6 +19,7 @@ extern "C" {
 /* constants -----------------------------------------------------------------*/
 #define POLYCRC32   0xEDB88320u /* CRC32 polynomial */
 #define POLYCRC24Q  0x1864CFBu  /* CRC24Q polynomial */
+#define POLYCRC16   0x1021u     /* CRC16 (CCITT) polynomial */
 
 #define SQR(x)      ((x)*(x))
 #define MAX_VAR_EPH SQR(300.0)  /* max variance eph to reject satellite (m^2) */
@@ -39,13 +40,20 @@ EXPORT double sat2freq(int sat, uint8_t code, const nav_t *nav);
 EXPORT int  code2idx(int sys, uint8_t code);
 EXPORT void setcodepri(int sys, int idx, const char *pri);
 EXPORT int  getcodepri(int sys, uint8_t code, const char *opt);
+EXPORT void getcodepris(int sys, const char *opt, uint8_t *pri);
+EXPORT uint32_t getcodepriver(void);
 
 /* receiver raw data functions -----------------------------------------------*/
 EXPORT uint32_t getbitu(const uint8_t *buff, int pos, int len);
 EXPORT int32_t  getbits(const uint8_t *buff, int pos, int len);
 EXPORT void setbitu(uint8_t *buff, int pos, int len, uint32_t data);
 EXPORT void setbits(uint8_t *buff, int pos, int len, int32_t  data);
+EXPORT uint32_t rtk_crc32  (const uint8_t *buff, int len);
+EXPORT uint16_t rtk_crc16  (const uint8_t *buff, int len);
 EXPORT uint32_t rtk_crc24q(const uint8_t *buff, int len);
+EXPORT uint32_t rtk_crc24q_upd(uint32_t crc, const uint8_t *buff, int len);
+EXPORT void rtk_crc24q_n(const uint8_t **buff, const int *len, int n,
+                         uint32_t *crc);
 
 /* debug trace functions -----------------------------------------------------*/
 EXPORT void trace    (int level, const char *format, ...);
@@ -73,6 +81,7 @@ EXPORT gtime_t bdt2gpst (gtime_t t);
 EXPORT gtime_t timeget  (void);
 EXPORT void    timeset  (gtime_t t);
 EXPORT void    timereset(void);
+EXPORT gtime_t timeget_ref(void);
 EXPORT double  time2doy (gtime_t t);
 EXPORT double  utc2gmst (gtime_t t, double ut1_utc);
 